@@ -0,0 +1,148 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec3 fragPosition;
+
+// Output fragment color
+out vec4 finalColor;
+
+// Uniform inputs
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform vec3 planetCenter;
+uniform vec3 atmosphereRadii;      // Bottom and top radius in km, km per world unit
+uniform vec3 rayleighScattering;
+uniform vec3 mieScattering;
+uniform float miePhaseG;
+uniform float muSMin;
+uniform float exposure;
+
+// Single scattering table: rayleigh rgb and mie red, see AtmosphereLUT.h
+uniform sampler2D scatteringTexture;
+
+// Must match AtmosphereLUT.h
+#define SCATTERING_TEXTURE_R_SIZE 32
+#define SCATTERING_TEXTURE_MU_SIZE 128
+#define SCATTERING_TEXTURE_MU_S_SIZE 32
+#define SCATTERING_TEXTURE_NU_SIZE 8
+
+const float PI = 3.14159265359;
+
+float GetTextureCoordFromUnitRange(float x, int textureSize)
+{
+    return 0.5/float(textureSize) + x*(1.0 - 1.0/float(textureSize));
+}
+
+float DistanceToTop(float r, float mu)
+{
+    float top = atmosphereRadii.y;
+    return max(-r*mu + sqrt(max(r*r*(mu*mu - 1.0) + top*top, 0.0)), 0.0);
+}
+
+// One (r, mu, mu_s) lookup in a single r and nu slice of the 2D layout
+vec4 SampleSlice(int rSlice, int nuSlice, float uMu, float uMuS)
+{
+    uMu = clamp(uMu, 0.5/float(SCATTERING_TEXTURE_MU_SIZE), 1.0 - 0.5/float(SCATTERING_TEXTURE_MU_SIZE));
+    uMuS = clamp(uMuS, 0.5/float(SCATTERING_TEXTURE_MU_S_SIZE), 1.0 - 0.5/float(SCATTERING_TEXTURE_MU_S_SIZE));
+    vec2 uv = vec2((float(nuSlice) + uMuS)/float(SCATTERING_TEXTURE_NU_SIZE),
+                   (float(rSlice) + uMu)/float(SCATTERING_TEXTURE_R_SIZE));
+    return texture(scatteringTexture, uv);
+}
+
+// Bruneton's (r, mu, mu_s, nu) parameterization, interpolated over r and nu
+vec4 GetScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround)
+{
+    float bottom = atmosphereRadii.x;
+    float top = atmosphereRadii.y;
+    float H = sqrt(top*top - bottom*bottom);
+    float rho = sqrt(max(r*r - bottom*bottom, 0.0));
+    float uR = GetTextureCoordFromUnitRange(rho/H, SCATTERING_TEXTURE_R_SIZE);
+
+    // Lower half of the mu range holds rays that hit the ground
+    float rMu = r*mu;
+    float discriminant = rMu*rMu - r*r + bottom*bottom;
+    float uMu;
+    if (rayIntersectsGround) {
+        float d = -rMu - sqrt(max(discriminant, 0.0));
+        float dMin = r - bottom;
+        float dMax = rho;
+        float x = (dMax == dMin) ? 0.0 : (d - dMin)/(dMax - dMin);
+        uMu = 0.5 - 0.5*GetTextureCoordFromUnitRange(x, SCATTERING_TEXTURE_MU_SIZE/2);
+    } else {
+        float d = -rMu + sqrt(max(discriminant + H*H, 0.0));
+        float dMin = top - r;
+        float dMax = rho + H;
+        uMu = 0.5 + 0.5*GetTextureCoordFromUnitRange((d - dMin)/(dMax - dMin), SCATTERING_TEXTURE_MU_SIZE/2);
+    }
+
+    // Sun zenith, compressed towards the horizon
+    float d = DistanceToTop(bottom, muS);
+    float dMin = top - bottom;
+    float dMax = H;
+    float a = (d - dMin)/(dMax - dMin);
+    float A = (DistanceToTop(bottom, muSMin) - dMin)/(dMax - dMin);
+    float uMuS = GetTextureCoordFromUnitRange(max(1.0 - a/A, 0.0)/(1.0 + a), SCATTERING_TEXTURE_MU_S_SIZE);
+
+    // Two r slices and two nu slices
+    float rCoord = clamp(uR*float(SCATTERING_TEXTURE_R_SIZE) - 0.5, 0.0, float(SCATTERING_TEXTURE_R_SIZE - 1));
+    float nuCoord = (nu + 1.0)*0.5*float(SCATTERING_TEXTURE_NU_SIZE - 1);
+    int r0 = int(floor(rCoord));
+    int n0 = int(floor(nuCoord));
+    int r1 = min(r0 + 1, SCATTERING_TEXTURE_R_SIZE - 1);
+    int n1 = min(n0 + 1, SCATTERING_TEXTURE_NU_SIZE - 1);
+    float rLerp = rCoord - float(r0);
+    float nuLerp = nuCoord - float(n0);
+
+    vec4 near = mix(SampleSlice(r0, n0, uMu, uMuS), SampleSlice(r0, n1, uMu, uMuS), nuLerp);
+    vec4 far = mix(SampleSlice(r1, n0, uMu, uMuS), SampleSlice(r1, n1, uMu, uMuS), nuLerp);
+    return mix(near, far, rLerp);
+}
+
+float RayleighPhase(float nu)
+{
+    return 3.0/(16.0*PI)*(1.0 + nu*nu);
+}
+
+float MiePhase(float g, float nu)
+{
+    float k = 3.0/(8.0*PI)*(1.0 - g*g)/(2.0 + g*g);
+    return k*(1.0 + nu*nu)/pow(1.0 + g*g - 2.0*g*nu, 1.5);
+}
+
+void main()
+{
+    float bottom = atmosphereRadii.x;
+    float top = atmosphereRadii.y;
+
+    // Work in km around the planet center
+    vec3 camera = (viewPos - planetCenter)*atmosphereRadii.z;
+    vec3 viewDir = normalize(fragPosition - viewPos);
+    vec3 sunDir = normalize(lightPos - planetCenter);
+
+    // Start the ray where it enters the atmosphere
+    float r = length(camera);
+    float rMu = dot(camera, viewDir);
+    if (r > top) {
+        float discriminant = rMu*rMu - r*r + top*top;
+        if (discriminant < 0.0 || rMu > 0.0) discard;
+        camera += viewDir*(-rMu - sqrt(discriminant));
+        r = top;
+        rMu = dot(camera, viewDir);
+    }
+    r = clamp(r, bottom, top);
+
+    float mu = rMu/r;
+    float muS = dot(camera, sunDir)/r;
+    float nu = dot(viewDir, sunDir);
+    bool rayIntersectsGround = mu < 0.0 && r*r*(mu*mu - 1.0) + bottom*bottom >= 0.0;
+
+    // Mie is rebuilt from its red channel and the rayleigh ratio
+    vec4 scattering = GetScattering(r, mu, muS, nu, rayIntersectsGround);
+    vec3 rayleigh = scattering.rgb;
+    vec3 mie = (scattering.r > 0.0) ?
+        scattering.rgb*scattering.a/scattering.r*(rayleighScattering.r/mieScattering.r)*(mieScattering/rayleighScattering) :
+        vec3(0.0);
+
+    vec3 radiance = rayleigh*RayleighPhase(nu) + mie*MiePhase(miePhaseG, nu);
+    finalColor = vec4(1.0 - exp(-radiance*exposure), 1.0);
+}
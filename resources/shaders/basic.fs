@@ -29,6 +29,155 @@ uniform bool hasSpecularMap = false;
 uniform bool hasNormalMap = false;
 uniform bool hasCloudMap = false;
 
+// Virtual texture (replaces diffuse and normal maps when enabled)
+uniform bool hasVirtualTexture = false;
+uniform sampler2D vtIndirection;   // One texel per page, one mip per page level
+uniform sampler2D vtPhysical;      // Tile cache atlas, layers side by side
+uniform vec4 vtPageParams;         // Pages x/y at mip 0, tile size, mip count
+uniform vec4 vtAtlasParams;        // Atlas width/height, slot size, border
+uniform vec2 vtLayerParams;        // Layer count, layer stride in texels
+
+// Spheres that can eclipse the light (center xyz, radius w)
+#define MAX_OCCLUDERS 8
+uniform int occluderCount = 0;
+uniform vec4 occluders[MAX_OCCLUDERS];
+uniform float lightRadius = 0.0;   // Radius of the light disk, sets penumbra width
+
+// Atmosphere transmittance from the precomputed table (see AtmosphereLUT.h)
+uniform bool hasAtmosphere = false;
+uniform sampler2D transmittanceLUT;
+uniform vec3 planetCenter;
+uniform vec3 atmosphereRadii;      // Bottom and top radius in km, km per world unit
+
+// Clustered local lights (see ClusteredLights.h), data textures on units 12-14
+uniform bool hasClusteredLights = false;
+uniform sampler2D clusterGrid;     // Offset and count per cluster, x + y*gridX across, slice down
+uniform sampler2D clusterIndices;  // Light indices of all clusters, row major
+uniform sampler2D clusterLights;   // Per light: position and range, then color
+uniform mat4 clusterViewProjection;
+uniform vec4 clusterGridParams;    // Clusters x, y, z, log(far/near)
+uniform float clusterNear;
+
+const float PI = 3.14159265359;
+
+// Area of the intersection of two disks with radii r1, r2 and center distance d
+float DiskOverlap(float r1, float r2, float d)
+{
+    if (d >= r1 + r2) return 0.0;
+    float rMin = min(r1, r2);
+    if (d <= abs(r1 - r2)) return PI*rMin*rMin;
+
+    float a1 = acos(clamp((d*d + r1*r1 - r2*r2)/(2.0*d*r1), -1.0, 1.0));
+    float a2 = acos(clamp((d*d + r2*r2 - r1*r1)/(2.0*d*r2), -1.0, 1.0));
+    float k = (-d + r1 + r2)*(d + r1 - r2)*(d - r1 + r2)*(d + r1 + r2);
+    return r1*r1*a1 + r2*r2*a2 - 0.5*sqrt(max(k, 0.0));
+}
+
+// Fraction of the light disk visible from a point, umbra gives 0 and
+// penumbra the uncovered share of the disk as seen from that point
+float EclipseVisibility(vec3 position)
+{
+    vec3 toLight = lightPos - position;
+    float lightDistance = length(toLight);
+    vec3 lightDir = toLight/lightDistance;
+    float lightAngle = max(asin(clamp(lightRadius/lightDistance, 0.0, 1.0)), 1e-4);
+
+    float visibility = 1.0;
+    for (int i = 0; i < occluderCount; i++) {
+        vec3 toOccluder = occluders[i].xyz - position;
+        float occluderDistance = length(toOccluder);
+
+        // Only spheres between the point and the light can shadow it
+        if (occluderDistance <= occluders[i].w || occluderDistance > lightDistance) continue;
+        if (dot(toOccluder, lightDir) <= 0.0) continue;
+
+        vec3 occluderDir = toOccluder/occluderDistance;
+        float occluderAngle = asin(occluders[i].w/occluderDistance);
+        float separation = atan(length(cross(occluderDir, lightDir)), dot(occluderDir, lightDir));
+
+        float covered = DiskOverlap(lightAngle, occluderAngle, separation)/(PI*lightAngle*lightAngle);
+        visibility *= 1.0 - clamp(covered, 0.0, 1.0);
+    }
+    return visibility;
+}
+
+// Sunlight reaching a point after passing through the atmosphere
+vec3 AtmosphereTransmittance(vec3 position, vec3 lightDir)
+{
+    float bottom = atmosphereRadii.x;
+    float top = atmosphereRadii.y;
+    vec3 p = (position - planetCenter)*atmosphereRadii.z;
+    float r = clamp(length(p), bottom, top);
+    float mu = dot(p, lightDir)/max(length(p), 1e-4);
+
+    // Bruneton's (r, mu) to texture mapping
+    float H = sqrt(top*top - bottom*bottom);
+    float rho = sqrt(max(r*r - bottom*bottom, 0.0));
+    float d = max(-r*mu + sqrt(max(r*r*(mu*mu - 1.0) + top*top, 0.0)), 0.0);
+    float dMin = top - r;
+    float dMax = rho + H;
+    vec2 size = vec2(textureSize(transmittanceLUT, 0));
+    vec2 x = clamp(vec2((d - dMin)/(dMax - dMin), rho/H), 0.0, 1.0);
+    return texture(transmittanceLUT, 0.5/size + x*(1.0 - 1.0/size)).rgb;
+}
+
+// Diffuse and specular light from the local lights of this fragment's cluster
+vec3 ClusteredLighting(vec3 position, vec3 normal, vec3 viewDir, vec3 albedo, float specularIntensity)
+{
+    // Tile from the clip position, slice from the exponential view depth
+    vec4 clip = clusterViewProjection * vec4(position, 1.0);
+    vec2 tile = (clip.xy/clip.w*0.5 + 0.5)*clusterGridParams.xy;
+    float slice = log(max(clip.w, clusterNear)/clusterNear)/clusterGridParams.w*clusterGridParams.z;
+    ivec3 cluster = clamp(ivec3(vec3(tile, slice)), ivec3(0), ivec3(clusterGridParams.xyz) - 1);
+
+    vec2 range = texelFetch(clusterGrid, ivec2(cluster.x + cluster.y*int(clusterGridParams.x), cluster.z), 0).xy;
+    int first = int(range.x);
+    int count = int(range.y);
+    int indexWidth = textureSize(clusterIndices, 0).x;
+
+    vec3 result = vec3(0.0);
+    for (int i = first; i < first + count; i++) {
+        int light = int(texelFetch(clusterIndices, ivec2(i % indexWidth, i / indexWidth), 0).r);
+        vec4 positionRange = texelFetch(clusterLights, ivec2(light, 0), 0);
+        vec3 color = texelFetch(clusterLights, ivec2(light, 1), 0).rgb;
+
+        vec3 toLight = positionRange.xyz - position;
+        float ratio = dot(toLight, toLight)/(positionRange.w*positionRange.w);
+        if (ratio >= 1.0) continue;
+
+        // Smooth falloff that reaches zero at the light's range
+        float falloff = 1.0 - ratio*ratio;
+        falloff *= falloff;
+
+        vec3 lightDir = normalize(toLight);
+        float diff = max(dot(normal, lightDir), 0.0);
+        float spec = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), 32.0);
+        result += color*falloff*(albedo*diff + spec*specularIntensity);
+    }
+    return result;
+}
+
+// Translate a virtual texture coordinate to an atlas texel position (layer 0)
+vec2 VirtualTexturePhysical(vec2 uv)
+{
+    // Requested mip from the screen-space texel footprint
+    vec2 texel = uv*vtPageParams.xy*vtPageParams.z;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5*log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    int level = int(clamp(floor(lod), 0.0, vtPageParams.w - 1.0));
+
+    // The indirection mip holds the finest resident page at or above that level
+    ivec2 levelPages = max(ivec2(vtPageParams.xy) >> level, ivec2(1));
+    ivec2 page = clamp(ivec2(floor(fract(uv)*vec2(levelPages))), ivec2(0), levelPages - 1);
+    vec4 entry = floor(texelFetch(vtIndirection, page, level)*255.0 + 0.5);
+
+    // Position inside the resident page, which may be coarser than requested
+    vec2 residentPages = max(floor(vtPageParams.xy/exp2(entry.b)), vec2(1.0));
+    vec2 local = fract(uv*residentPages);
+    return entry.rg*vtAtlasParams.z + vtAtlasParams.w + local*vtPageParams.z;
+}
+
 void main()
 {
     // Define default values for missing textures
@@ -38,11 +187,17 @@ void main()
     vec3 defaultNormal = fragNormal;
     vec4 defaultCloud = vec4(0.0, 0.0, 0.0, 1.0);
 
+    // Virtual texture lookup, shared by the diffuse and normal layers
+    vec2 vtTexel = hasVirtualTexture ? VirtualTexturePhysical(fragTexCoord) : vec2(0.0);
+    bool hasVirtualNormal = hasVirtualTexture && vtLayerParams.x > 1.0;
+
     // Normal calculation - use normal map if available, otherwise use fragment normal
     vec3 normal;
-    if (hasNormalMap) {
+    if (hasNormalMap || hasVirtualNormal) {
         // Sample normal map (convert from RGB to normal vector)
-        vec3 normalMapValue = texture(normalMap, fragTexCoord).rgb;
+        vec3 normalMapValue = hasVirtualNormal ?
+            texture(vtPhysical, (vtTexel + vec2(vtLayerParams.y, 0.0))/vtAtlasParams.xy).rgb :
+            texture(normalMap, fragTexCoord).rgb;
         normalMapValue = normalMapValue * 2.0 - 1.0;
         
         // Adjust normal map strength (increase for more pronounced effect)
@@ -59,9 +214,21 @@ void main()
     // Calculate the light direction and distance
     vec3 lightDir = normalize(lightPos - fragPosition);
     float diff = max(dot(normal, lightDir), 0.0);
+
+    // Eclipse shadows from other bodies darken everything lit by the light
+    float eclipse = (occluderCount > 0) ? EclipseVisibility(fragPosition) : 1.0;
+    diff *= eclipse;
+
+    // Sunlight is reddened and dimmed by the air it crosses
+    vec3 sunTransmittance = hasAtmosphere ? AtmosphereTransmittance(fragPosition, lightDir) : vec3(1.0);
     
     // Sample texture color or use default if not available
-    vec4 texColor = hasDiffuseMap ? texture(diffuseMap, fragTexCoord) : defaultDiffuse;
+    vec4 texColor;
+    if (hasVirtualTexture) {
+        texColor = texture(vtPhysical, vtTexel/vtAtlasParams.xy);
+    } else {
+        texColor = hasDiffuseMap ? texture(diffuseMap, fragTexCoord) : defaultDiffuse;
+    }
     
     // Sample cloud texture or use default if not available
     vec4 cloudColor = hasCloudMap ? texture(cloudMap, fragTexCoord) : defaultCloud;
@@ -73,14 +240,14 @@ void main()
     vec4 ambient = vec4(0.3, 0.3, 0.3, 1.0) * texColor * 0.1;
     
     // Calculate diffuse component
-    vec4 diffuse = texColor * diff;
+    vec4 diffuse = texColor * diff * vec4(sunTransmittance, 1.0);
     diffuse.a = 1.0;
     
     // Calculate specular reflection (Phong)
     vec3 viewDir = normalize(viewPos - fragPosition);
     vec3 reflectDir = reflect(-lightDir, normal);
     float shininess = 32.0;
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess) * eclipse;
     
     // Use the specular map to determine the specular intensity
     float specularIntensity;
@@ -91,7 +258,7 @@ void main()
         specularIntensity = 0.0; // Default specular intensity
     }
     
-    vec4 specular = vec4(0.5, 0.5, 0.5, 1.0) * spec * specularIntensity;
+    vec4 specular = vec4(0.5, 0.5, 0.5, 1.0) * spec * specularIntensity * vec4(sunTransmittance, 1.0);
     
     // Reduce specular in cloudy areas if cloud map is available
     if (hasCloudMap) {
@@ -100,6 +267,11 @@ void main()
     
       // Calculate final color
     finalColor = ambient + diffuse + specular;
+
+    // Local lights shine on the surface, under the clouds
+    if (hasClusteredLights) {
+        finalColor.rgb += ClusteredLighting(fragPosition, normal, viewDir, texColor.rgb, specularIntensity);
+    }
     
     // Add emission if available
     if (hasEmissionMap) {
@@ -5,7 +5,11 @@ in vec3 vertexPosition;
 in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
-// Note: vertexTangent may not be available in Raylib's default sphere mesh
+in vec3 vertexTangent;  // Only provided by compact meshes
+
+// Compact meshes (see SphereMesh.h) store snorm16 positions and octahedral
+// normals/tangents, the tangent's z holds the bitangent handedness
+uniform bool compactVertices = false;
 
 // Input uniform values
 uniform mat4 mvp2;
@@ -18,6 +22,16 @@ out vec3 fragPosition;
 out vec3 fragNormal;
 out mat3 TBN;           // Tangent-Bitangent-Normal matrix for normal mapping
 
+// Unfold an octahedral encoded unit vector
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
 void main()
 {
     // Transform vertex position and normal by model matrix
@@ -25,16 +39,26 @@ void main()
     
     // Normal matrix: transpose of the inverse of the upper-left 3x3 part of the model matrix
     mat3 normalMatrix = transpose(inverse(mat3(matModel2)));
-    vec3 worldNormal = normalize(normalMatrix * vertexNormal);
-    
-    // Calculate tangent space for sphere
-    // For a sphere, we can derive the tangent from the normal and texture coordinates
-    vec3 c1 = cross(worldNormal, vec3(0.0, 0.0, 1.0));
-    vec3 c2 = cross(worldNormal, vec3(0.0, 1.0, 0.0));
+    vec3 objectNormal = compactVertices ? OctahedralDecode(vertexNormal.xy) : vertexNormal;
+    vec3 worldNormal = normalize(normalMatrix * objectNormal);
     
-    // Use the non-zero cross product with largest magnitude
-    vec3 worldTangent = normalize(length(c1) > length(c2) ? c1 : c2);
-    vec3 worldBitangent = normalize(cross(worldNormal, worldTangent));
+    vec3 worldTangent;
+    vec3 worldBitangent;
+    if (compactVertices) {
+        // Tangent follows +u, the bitangent points up the texture
+        worldTangent = normalize(mat3(matModel2) * OctahedralDecode(vertexTangent.xy));
+        worldTangent = normalize(worldTangent - worldNormal * dot(worldNormal, worldTangent));
+        worldBitangent = cross(worldNormal, worldTangent) * vertexTangent.z;
+    } else {
+        // Calculate tangent space for sphere
+        // For a sphere, we can derive the tangent from the normal and texture coordinates
+        vec3 c1 = cross(worldNormal, vec3(0.0, 0.0, 1.0));
+        vec3 c2 = cross(worldNormal, vec3(0.0, 1.0, 0.0));
+        
+        // Use the non-zero cross product with largest magnitude
+        worldTangent = normalize(length(c1) > length(c2) ? c1 : c2);
+        worldBitangent = normalize(cross(worldNormal, worldTangent));
+    }
     
     // Create TBN matrix
     TBN = mat3(worldTangent, worldBitangent, worldNormal);
@@ -0,0 +1,15 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in float fragFade;
+
+// Output fragment color
+out vec4 finalColor;
+
+// Uniform inputs
+uniform vec4 trailColor;
+
+void main()
+{
+    finalColor = vec4(trailColor.rgb, trailColor.a*fragFade);
+}
@@ -0,0 +1,20 @@
+#version 330
+
+// Input vertex attributes
+in vec4 vertexPosition;   // World position, w is the emission time
+
+// Input uniform values
+uniform mat4 mvp;
+uniform float currentTime;
+uniform float fadeTime;
+
+// Output vertex attributes (to fragment shader)
+out float fragFade;
+
+void main()
+{
+    // Older points fade out
+    fragFade = clamp(1.0 - (currentTime - vertexPosition.w)/fadeTime, 0.0, 1.0);
+
+    gl_Position = mvp*vec4(vertexPosition.xyz, 1.0);
+}
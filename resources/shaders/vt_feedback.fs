@@ -0,0 +1,29 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+
+// Output fragment color
+out vec4 finalColor;
+
+// Virtual texture being drawn
+uniform vec4 vtPageParams;     // Pages x/y at mip 0, tile size, mip count
+uniform int vtTextureId;       // 1-based id, 0 is the cleared background
+uniform float vtMipBias;       // Compensates for the reduced feedback resolution
+
+void main()
+{
+    // Mip from the screen-space texel footprint
+    vec2 texel = fragTexCoord*vtPageParams.xy*vtPageParams.z;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5*log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + vtMipBias;
+    float mip = clamp(floor(lod), 0.0, vtPageParams.w - 1.0);
+
+    // Page containing this texel at that mip
+    vec2 levelPages = max(floor(vtPageParams.xy/exp2(mip)), vec2(1.0));
+    vec2 page = clamp(floor(fract(fragTexCoord)*levelPages), vec2(0.0), levelPages - 1.0);
+
+    // Page x, page y, mip and texture id, read back on the CPU
+    finalColor = vec4(page, mip, float(vtTextureId))/255.0;
+}
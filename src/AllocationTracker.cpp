@@ -0,0 +1,162 @@
+#include "AllocationTracker.h"
+#include "raylib.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> freeCount(0);
+static std::atomic<uint64_t> allocatedBytes(0);
+
+static void CountAllocation(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static void CountFree(void* memory) {
+    if (memory != nullptr) freeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+// Global replacements, the array, nothrow and sized forms are replaced too
+// so every path is counted the same on every standard library
+static void* CountedAllocate(size_t size) {
+    void* memory = malloc(size ? size : 1);
+    if (memory == nullptr) throw std::bad_alloc();
+    CountAllocation(size);
+    return memory;
+}
+
+static void* CountedAllocateAligned(size_t size, std::align_val_t alignment) {
+    size_t align = (size_t)alignment;
+    if (align < sizeof(void*)) align = sizeof(void*);
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size ? size : 1, align);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, align, size ? size : 1) != 0) memory = nullptr;
+#endif
+    if (memory == nullptr) throw std::bad_alloc();
+    CountAllocation(size);
+    return memory;
+}
+
+static void CountedFree(void* memory) {
+    CountFree(memory);
+    free(memory);
+}
+
+static void CountedFreeAligned(void* memory) {
+    CountFree(memory);
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void* operator new(size_t size) { return CountedAllocate(size); }
+void* operator new[](size_t size) { return CountedAllocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return CountedAllocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return CountedAllocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* memory) noexcept { CountedFree(memory); }
+void operator delete[](void* memory) noexcept { CountedFree(memory); }
+void operator delete(void* memory, size_t) noexcept { CountedFree(memory); }
+void operator delete[](void* memory, size_t) noexcept { CountedFree(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { CountedFree(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { CountedFree(memory); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+void operator delete(void* memory, std::align_val_t) noexcept { CountedFreeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { CountedFreeAligned(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { CountedFreeAligned(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { CountedFreeAligned(memory); }
+
+#endif // TRACK_ALLOCATIONS
+
+AllocationStats GetAllocationTotals() {
+    AllocationStats totals;
+    totals.allocations = allocationCount.load(std::memory_order_relaxed);
+    totals.frees = freeCount.load(std::memory_order_relaxed);
+    totals.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    return totals;
+}
+
+bool IsAllocationHookEnabled() {
+#ifdef TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void RecordAllocation(size_t size) {
+    CountAllocation(size);
+}
+
+void RecordFree(void* memory) {
+    CountFree(memory);
+}
+
+FrameAllocationTracker::FrameAllocationTracker(int warmupFrames)
+    : frameStart(GetAllocationTotals()),
+      lastFrame({ 0, 0, 0 }),
+      frameIndex(0),
+      steadyFrame((uint64_t)warmupFrames),
+      warmupFrames(warmupFrames),
+      violationCount(0),
+      lastViolationFrame(0)
+{
+}
+
+void FrameAllocationTracker::EndFrame() {
+    AllocationStats totals = GetAllocationTotals();
+    lastFrame.allocations = totals.allocations - frameStart.allocations;
+    lastFrame.frees = totals.frees - frameStart.frees;
+    lastFrame.bytes = totals.bytes - frameStart.bytes;
+    frameStart = totals;
+
+    if (IsSteadyState() && lastFrame.allocations > 0) {
+        // Log the first one, the count shows how often it keeps happening
+        if (violationCount == 0) {
+            TraceLog(LOG_WARNING, "ALLOC: Steady-state frame %llu made %llu allocations (%llu bytes)",
+                     (unsigned long long)frameIndex, (unsigned long long)lastFrame.allocations,
+                     (unsigned long long)lastFrame.bytes);
+        }
+        violationCount++;
+        lastViolationFrame = frameIndex;
+    }
+    frameIndex++;
+}
+
+void FrameAllocationTracker::ResetSteadyState() {
+    steadyFrame = frameIndex + (uint64_t)warmupFrames;
+    violationCount = 0;
+    lastViolationFrame = 0;
+}
+
+const AllocationStats& FrameAllocationTracker::GetLastFrame() const {
+    return lastFrame;
+}
+
+bool FrameAllocationTracker::IsSteadyState() const {
+    return frameIndex >= steadyFrame;
+}
+
+uint64_t FrameAllocationTracker::GetFrameIndex() const {
+    return frameIndex;
+}
+
+int FrameAllocationTracker::GetViolationCount() const {
+    return violationCount;
+}
+
+uint64_t FrameAllocationTracker::GetLastViolationFrame() const {
+    return lastViolationFrame;
+}
@@ -0,0 +1,64 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap activity, counted by the global operator new/delete replacements when
+// built with TRACK_ALLOCATIONS and by allocators that report to the counters
+// (main.cpp routes ImGui's through them).
+//
+// raylib allocates with RL_MALLOC, which is not counted. In the frame loop
+// that only happens while textures stream: TextureResidency's loader thread
+// decodes images and Update copies a lower mip chain on a downgrade. Both
+// follow a residency change, a frame that renders an unchanged scene does
+// neither. Virtual texture feedback reads back through pixel pack buffers
+// and does not allocate.
+struct AllocationStats {
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes;             // Requested by allocations
+};
+
+// Totals since startup, from every thread
+AllocationStats GetAllocationTotals();
+
+// True when operator new/delete are counted, not just ImGui
+bool IsAllocationHookEnabled();
+
+// Count an allocation or free made outside operator new/delete
+void RecordAllocation(size_t size);
+void RecordFree(void* memory);
+
+// Splits the totals into frames and flags steady-state frames that touch
+// the heap. Frames are steady once warmupFrames have passed since the
+// start or the last ResetSteadyState (call it after loading or resizing).
+class FrameAllocationTracker {
+public:
+    // Constructor/Destructor
+    explicit FrameAllocationTracker(int warmupFrames);
+    ~FrameAllocationTracker() = default;
+
+    // Close the current frame, call once per frame after EndDrawing
+    void EndFrame();
+    void ResetSteadyState();
+
+    // Heap activity of the last finished frame
+    const AllocationStats& GetLastFrame() const;
+
+    bool IsSteadyState() const;
+    uint64_t GetFrameIndex() const;
+    int GetViolationCount() const;          // Steady-state frames that allocated
+    uint64_t GetLastViolationFrame() const;
+
+private:
+    AllocationStats frameStart;
+    AllocationStats lastFrame;
+    uint64_t frameIndex;
+    uint64_t steadyFrame;       // First frame that counts as steady
+    int warmupFrames;
+    int violationCount;
+    uint64_t lastViolationFrame;
+};
+
+#endif // ALLOCATION_TRACKER_H
@@ -0,0 +1,154 @@
+#include "Atmosphere.h"
+#include "Tools.h"
+#include "rlgl.h"
+#include "raymath.h"
+#include <thread>
+
+Atmosphere::Atmosphere()
+    : parameters(GetEarthAtmosphereParameters()),
+      exposure(20.0f),
+      mvpLoc(-1),
+      modelLoc(-1),
+      lightPosLoc(-1),
+      viewPosLoc(-1),
+      planetCenterLoc(-1),
+      radiiLoc(-1),
+      rayleighScatteringLoc(-1),
+      mieScatteringLoc(-1),
+      miePhaseGLoc(-1),
+      muSMinLoc(-1),
+      exposureLoc(-1)
+{
+    transmittanceTexture = { 0 };
+    scatteringTexture = { 0 };
+    shell = { 0 };
+    shader = { 0 };
+}
+
+Atmosphere::~Atmosphere() {
+    Unload();
+}
+
+bool Atmosphere::Load(const char* cachePath, const AtmosphereParameters& newParameters) {
+    AtmosphereLUT lut;
+    if (!lut.Load(cachePath, newParameters)) {
+        // Same bake as the headless AtmosphereBake tool
+        TraceLog(LOG_INFO, "ATMOSPHERE: Baking lookup tables to %s", cachePath);
+        int threadCount = (int)std::thread::hardware_concurrency();
+        lut.Bake(newParameters, threadCount > 0 ? threadCount : 4);
+        if (!lut.Save(cachePath)) {
+            TraceLog(LOG_WARNING, "ATMOSPHERE: Failed to write cache %s", cachePath);
+        }
+    }
+    parameters = lut.GetParameters();
+
+    transmittanceTexture = LoadTable(lut.GetTransmittanceData(), TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT);
+    scatteringTexture = LoadTable(lut.GetScatteringData(), SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT);
+    if (transmittanceTexture.id == 0 || scatteringTexture.id == 0) {
+        TraceLog(LOG_WARNING, "ATMOSPHERE: Failed to upload lookup tables");
+        Unload();
+        return false;
+    }
+
+    // Unit sphere scaled to the top of the atmosphere when drawn
+    shell = LoadModelFromMesh(GenMeshSphere(1.0f, 64, 64));
+    shader = LoadShader("resources/shaders/basic.vs", "resources/shaders/atmosphere.fs");
+    shader.locs[SHADER_LOC_MAP_DIFFUSE] = GetShaderLocation(shader, "scatteringTexture");
+    shell.materials[0].shader = shader;
+    shell.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = scatteringTexture;
+
+    mvpLoc = GetShaderLocation(shader, "mvp2");
+    modelLoc = GetShaderLocation(shader, "matModel2");
+    lightPosLoc = GetShaderLocation(shader, "lightPos");
+    viewPosLoc = GetShaderLocation(shader, "viewPos");
+    planetCenterLoc = GetShaderLocation(shader, "planetCenter");
+    radiiLoc = GetShaderLocation(shader, "atmosphereRadii");
+    rayleighScatteringLoc = GetShaderLocation(shader, "rayleighScattering");
+    mieScatteringLoc = GetShaderLocation(shader, "mieScattering");
+    miePhaseGLoc = GetShaderLocation(shader, "miePhaseG");
+    muSMinLoc = GetShaderLocation(shader, "muSMin");
+    exposureLoc = GetShaderLocation(shader, "exposure");
+    return true;
+}
+
+Texture2D Atmosphere::LoadTable(const float* data, int width, int height) {
+    Texture2D texture = { 0 };
+    texture.id = rlLoadTexture(data, width, height, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1);
+    texture.width = width;
+    texture.height = height;
+    texture.mipmaps = 1;
+    texture.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32A32;
+    if (texture.id > 0) {
+        SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
+        SetTextureWrap(texture, TEXTURE_WRAP_CLAMP);
+    }
+    return texture;
+}
+
+void Atmosphere::Unload() {
+    if (transmittanceTexture.id > 0) UnloadTexture(transmittanceTexture);
+    if (scatteringTexture.id > 0) UnloadTexture(scatteringTexture);
+    transmittanceTexture = { 0 };
+    scatteringTexture = { 0 };
+
+    // UnloadModel leaves material shaders and textures to the caller
+    if (shell.meshCount > 0) UnloadModel(shell);
+    if (shader.id > 0) UnloadShader(shader);
+    shell = { 0 };
+    shader = { 0 };
+}
+
+bool Atmosphere::IsLoaded() const {
+    return scatteringTexture.id > 0;
+}
+
+void Atmosphere::Draw(const Camera3D& camera, const Vector3& center, float radius, const Vector3& lightPos) {
+    if (!IsLoaded()) return;
+
+    // World units are scaled so the planet surface is the bottom radius
+    float kmPerUnit = parameters.bottomRadius/radius;
+    float shellRadius = parameters.topRadius/kmPerUnit;
+    Matrix matModel = MatrixMultiply(MatrixScale(shellRadius, shellRadius, shellRadius),
+                                     MatrixTranslate(center.x, center.y, center.z));
+    Vector3 radii = { parameters.bottomRadius, parameters.topRadius, kmPerUnit };
+
+    SetShaderValueMatrix(shader, modelLoc, matModel);
+    SetShaderValueMatrix(shader, mvpLoc, GetViewProjectionMatrix(camera));
+    SetShaderValue(shader, lightPosLoc, &lightPos, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, viewPosLoc, &camera.position, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, planetCenterLoc, &center, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, radiiLoc, &radii, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, rayleighScatteringLoc, parameters.rayleighScattering, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, mieScatteringLoc, parameters.mieScattering, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, miePhaseGLoc, &parameters.miePhaseG, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(shader, muSMinLoc, &parameters.muSMin, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(shader, exposureLoc, &exposure, SHADER_UNIFORM_FLOAT);
+
+    // From inside the shell only its far side covers the view
+    bool inside = Vector3Distance(camera.position, center) < shellRadius;
+
+    // Scattered light is added on top of the scene without occluding it
+    BeginBlendMode(BLEND_ADDITIVE);
+    rlDisableDepthMask();
+    if (inside) rlSetCullFace(RL_CULL_FACE_FRONT);
+        DrawModel(shell, Vector3Zero(), 1.0f, WHITE);
+    if (inside) rlSetCullFace(RL_CULL_FACE_BACK);
+    rlEnableDepthMask();
+    EndBlendMode();
+}
+
+Texture2D Atmosphere::GetTransmittanceTexture() const {
+    return transmittanceTexture;
+}
+
+const AtmosphereParameters& Atmosphere::GetParameters() const {
+    return parameters;
+}
+
+void Atmosphere::SetExposure(float newExposure) {
+    exposure = newExposure;
+}
+
+float Atmosphere::GetExposure() const {
+    return exposure;
+}
@@ -0,0 +1,58 @@
+#ifndef ATMOSPHERE_H
+#define ATMOSPHERE_H
+
+#include "raylib.h"
+#include "AtmosphereLUT.h"
+
+// Physically based atmosphere shell around a body. Transmittance and single
+// scattering come from precomputed lookup tables, so the shell pass and the
+// surface shader only need a few texture fetches per pixel.
+class Atmosphere {
+public:
+    // Constructor/Destructor
+    Atmosphere();
+    ~Atmosphere();
+
+    // Load the lookup tables from cachePath, baking and saving them first
+    // when the cache is missing or was baked with other parameters
+    bool Load(const char* cachePath, const AtmosphereParameters& parameters);
+    void Unload();
+    bool IsLoaded() const;
+
+    // Draw the shell around a planet with the given center and surface radius
+    void Draw(const Camera3D& camera, const Vector3& center, float radius, const Vector3& lightPos);
+
+    // Lookup tables, sampled by basic.fs for sunlight transmittance
+    Texture2D GetTransmittanceTexture() const;
+    const AtmosphereParameters& GetParameters() const;
+
+    // Exposure used to tone map the scattered radiance
+    void SetExposure(float exposure);
+    float GetExposure() const;
+
+private:
+    AtmosphereParameters parameters;
+    Texture2D transmittanceTexture;
+    Texture2D scatteringTexture;
+    float exposure;
+
+    // Shell geometry and shader
+    Model shell;
+    Shader shader;
+    int mvpLoc;
+    int modelLoc;
+    int lightPosLoc;
+    int viewPosLoc;
+    int planetCenterLoc;
+    int radiiLoc;
+    int rayleighScatteringLoc;
+    int mieScatteringLoc;
+    int miePhaseGLoc;
+    int muSMinLoc;
+    int exposureLoc;
+
+    // Helper methods
+    Texture2D LoadTable(const float* data, int width, int height);
+};
+
+#endif // ATMOSPHERE_H
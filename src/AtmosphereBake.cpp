@@ -0,0 +1,30 @@
+// Headless atmosphere lookup table baker, usable without a window or GPU.
+// Usage: AtmosphereBake [output path] [thread count]
+#include "AtmosphereLUT.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    const char* outputPath = (argc > 1) ? argv[1] : "resources/atmosphere.lut";
+    int threadCount = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 4;
+
+    printf("Baking atmosphere lookup tables with %i threads\n", threadCount);
+    auto start = std::chrono::steady_clock::now();
+
+    AtmosphereLUT lut;
+    lut.Bake(GetEarthAtmosphereParameters(), threadCount);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Baked in %.2f s\n", seconds);
+
+    if (!lut.Save(outputPath)) {
+        fprintf(stderr, "Failed to write %s\n", outputPath);
+        return 1;
+    }
+    printf("Wrote %s\n", outputPath);
+    return 0;
+}
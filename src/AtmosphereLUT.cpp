@@ -0,0 +1,357 @@
+#include "AtmosphereLUT.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+static const int ATMOSPHERE_LUT_VERSION = 1;
+static const int TRANSMITTANCE_SAMPLES = 500;
+static const int SCATTERING_SAMPLES = 50;
+
+// Cache file header
+struct AtmosphereLUTHeader {
+    char magic[4];      // "RSAT"
+    int version;
+    int transmittanceWidth;
+    int transmittanceHeight;
+    int scatteringWidth;
+    int scatteringHeight;
+    AtmosphereParameters parameters;
+};
+
+AtmosphereParameters GetEarthAtmosphereParameters() {
+    AtmosphereParameters parameters;
+    parameters.bottomRadius = 6360.0f;
+    parameters.topRadius = 6420.0f;
+    parameters.rayleighScattering[0] = 0.005802f;
+    parameters.rayleighScattering[1] = 0.013558f;
+    parameters.rayleighScattering[2] = 0.033100f;
+    parameters.rayleighScaleHeight = 8.0f;
+    for (int i = 0; i < 3; i++) {
+        parameters.mieScattering[i] = 0.003996f;
+        parameters.mieExtinction[i] = 0.004440f;
+        parameters.solarIrradiance[i] = 1.0f;
+    }
+    parameters.mieScaleHeight = 1.2f;
+    parameters.miePhaseG = 0.8f;
+    parameters.sunAngularRadius = 0.004675f;
+    parameters.muSMin = -0.2f;  // cos(102 degrees)
+    return parameters;
+}
+
+static double ClampCosine(double mu) {
+    return std::max(-1.0, std::min(1.0, mu));
+}
+
+static double SafeSqrt(double a) {
+    return sqrt(std::max(a, 0.0));
+}
+
+static double SmoothStep(double edge0, double edge1, double x) {
+    double t = std::max(0.0, std::min(1.0, (x - edge0)/(edge1 - edge0)));
+    return t*t*(3.0 - 2.0*t);
+}
+
+// Texel centers map to the ends of the [0, 1] range
+static double GetUnitRangeFromTextureCoord(double u, int textureSize) {
+    return (u - 0.5/textureSize)/(1.0 - 1.0/textureSize);
+}
+
+static double GetTextureCoordFromUnitRange(double x, int textureSize) {
+    return 0.5/textureSize + x*(1.0 - 1.0/textureSize);
+}
+
+// Density profiles, exponential in altitude
+static double ProfileDensity(double altitude, double scaleHeight) {
+    return std::max(0.0, std::min(1.0, exp(-altitude/scaleHeight)));
+}
+
+AtmosphereLUT::AtmosphereLUT()
+    : parameters(GetEarthAtmosphereParameters())
+{
+}
+
+double AtmosphereLUT::DistanceToTop(double r, double mu) const {
+    double top = parameters.topRadius;
+    double discriminant = r*r*(mu*mu - 1.0) + top*top;
+    return std::max(0.0, -r*mu + SafeSqrt(discriminant));
+}
+
+double AtmosphereLUT::DistanceToBottom(double r, double mu) const {
+    double bottom = parameters.bottomRadius;
+    double discriminant = r*r*(mu*mu - 1.0) + bottom*bottom;
+    return std::max(0.0, -r*mu - SafeSqrt(discriminant));
+}
+
+double AtmosphereLUT::ClampRadius(double r) const {
+    return std::max((double)parameters.bottomRadius, std::min((double)parameters.topRadius, r));
+}
+
+void AtmosphereLUT::ComputeTransmittanceRow(int row) {
+    double bottom = parameters.bottomRadius;
+    double top = parameters.topRadius;
+    double H = sqrt(top*top - bottom*bottom);
+
+    for (int column = 0; column < TRANSMITTANCE_TEXTURE_WIDTH; column++) {
+        // Texel to (r, mu)
+        double xMu = GetUnitRangeFromTextureCoord((column + 0.5)/TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_WIDTH);
+        double xR = GetUnitRangeFromTextureCoord((row + 0.5)/TRANSMITTANCE_TEXTURE_HEIGHT, TRANSMITTANCE_TEXTURE_HEIGHT);
+        double rho = H*xR;
+        double r = sqrt(rho*rho + bottom*bottom);
+        double dMin = top - r;
+        double dMax = rho + H;
+        double d = dMin + xMu*(dMax - dMin);
+        double mu = (d == 0.0) ? 1.0 : ClampCosine((H*H - rho*rho - d*d)/(2.0*r*d));
+
+        // Optical length to the top of the atmosphere (trapezoidal rule)
+        double dx = DistanceToTop(r, mu)/TRANSMITTANCE_SAMPLES;
+        double rayleighLength = 0.0;
+        double mieLength = 0.0;
+        for (int i = 0; i <= TRANSMITTANCE_SAMPLES; i++) {
+            double di = i*dx;
+            double ri = sqrt(di*di + 2.0*r*mu*di + r*r);
+            double weight = (i == 0 || i == TRANSMITTANCE_SAMPLES) ? 0.5 : 1.0;
+            rayleighLength += ProfileDensity(ri - bottom, parameters.rayleighScaleHeight)*weight*dx;
+            mieLength += ProfileDensity(ri - bottom, parameters.mieScaleHeight)*weight*dx;
+        }
+
+        float* texel = &transmittance[((size_t)row*TRANSMITTANCE_TEXTURE_WIDTH + column)*4];
+        for (int c = 0; c < 3; c++) {
+            texel[c] = (float)exp(-(parameters.rayleighScattering[c]*rayleighLength + parameters.mieExtinction[c]*mieLength));
+        }
+        texel[3] = 1.0f;
+    }
+}
+
+void AtmosphereLUT::SampleTransmittance(double r, double mu, double result[3]) const {
+    double bottom = parameters.bottomRadius;
+    double top = parameters.topRadius;
+    double H = sqrt(top*top - bottom*bottom);
+    double rho = SafeSqrt(r*r - bottom*bottom);
+    double d = DistanceToTop(r, mu);
+    double dMin = top - r;
+    double dMax = rho + H;
+    double u = GetTextureCoordFromUnitRange((d - dMin)/(dMax - dMin), TRANSMITTANCE_TEXTURE_WIDTH);
+    double v = GetTextureCoordFromUnitRange(rho/H, TRANSMITTANCE_TEXTURE_HEIGHT);
+
+    // Bilinear filtering between texel centers
+    double x = std::max(0.0, std::min((double)TRANSMITTANCE_TEXTURE_WIDTH - 1.0, u*TRANSMITTANCE_TEXTURE_WIDTH - 0.5));
+    double y = std::max(0.0, std::min((double)TRANSMITTANCE_TEXTURE_HEIGHT - 1.0, v*TRANSMITTANCE_TEXTURE_HEIGHT - 0.5));
+    int x0 = (int)x;
+    int y0 = (int)y;
+    int x1 = std::min(x0 + 1, TRANSMITTANCE_TEXTURE_WIDTH - 1);
+    int y1 = std::min(y0 + 1, TRANSMITTANCE_TEXTURE_HEIGHT - 1);
+    double fx = x - x0;
+    double fy = y - y0;
+
+    for (int c = 0; c < 3; c++) {
+        double t00 = transmittance[((size_t)y0*TRANSMITTANCE_TEXTURE_WIDTH + x0)*4 + c];
+        double t10 = transmittance[((size_t)y0*TRANSMITTANCE_TEXTURE_WIDTH + x1)*4 + c];
+        double t01 = transmittance[((size_t)y1*TRANSMITTANCE_TEXTURE_WIDTH + x0)*4 + c];
+        double t11 = transmittance[((size_t)y1*TRANSMITTANCE_TEXTURE_WIDTH + x1)*4 + c];
+        result[c] = (t00*(1.0 - fx) + t10*fx)*(1.0 - fy) + (t01*(1.0 - fx) + t11*fx)*fy;
+    }
+}
+
+void AtmosphereLUT::GetTransmittance(double r, double mu, double d, bool rayIntersectsGround, double result[3]) const {
+    double rD = ClampRadius(sqrt(d*d + 2.0*r*mu*d + r*r));
+    double muD = ClampCosine((r*mu + d)/rD);
+
+    // Transmittance between two points from the ratio of their lookups
+    double near[3];
+    double far[3];
+    if (rayIntersectsGround) {
+        SampleTransmittance(rD, -muD, near);
+        SampleTransmittance(r, -mu, far);
+    } else {
+        SampleTransmittance(r, mu, near);
+        SampleTransmittance(rD, muD, far);
+    }
+    for (int c = 0; c < 3; c++) {
+        result[c] = (far[c] > 0.0) ? std::min(near[c]/far[c], 1.0) : 0.0;
+    }
+}
+
+void AtmosphereLUT::GetTransmittanceToSun(double r, double muS, double result[3]) const {
+    // Fraction of the sun disk above the horizon
+    double sinThetaH = parameters.bottomRadius/r;
+    double cosThetaH = -sqrt(std::max(1.0 - sinThetaH*sinThetaH, 0.0));
+    double visible = SmoothStep(-sinThetaH*parameters.sunAngularRadius, sinThetaH*parameters.sunAngularRadius, muS - cosThetaH);
+
+    SampleTransmittance(r, muS, result);
+    for (int c = 0; c < 3; c++) {
+        result[c] *= visible;
+    }
+}
+
+void AtmosphereLUT::ComputeScatteringRow(int row) {
+    double bottom = parameters.bottomRadius;
+    double top = parameters.topRadius;
+    double H = sqrt(top*top - bottom*bottom);
+
+    int rIndex = row/SCATTERING_TEXTURE_MU_SIZE;
+    int muIndex = row % SCATTERING_TEXTURE_MU_SIZE;
+
+    // Radius from the r slice
+    double rho = H*GetUnitRangeFromTextureCoord((rIndex + 0.5)/SCATTERING_TEXTURE_R_SIZE, SCATTERING_TEXTURE_R_SIZE);
+    double r = sqrt(rho*rho + bottom*bottom);
+
+    // View zenith cosine, the lower half of the mu range holds rays hitting the ground
+    double muCoord = (muIndex + 0.5)/SCATTERING_TEXTURE_MU_SIZE;
+    double mu;
+    bool rayIntersectsGround;
+    if (muCoord < 0.5) {
+        double dMin = r - bottom;
+        double dMax = rho;
+        double d = dMin + (dMax - dMin)*GetUnitRangeFromTextureCoord(1.0 - 2.0*muCoord, SCATTERING_TEXTURE_MU_SIZE/2);
+        mu = (d == 0.0) ? -1.0 : ClampCosine(-(rho*rho + d*d)/(2.0*r*d));
+        rayIntersectsGround = true;
+    } else {
+        double dMin = top - r;
+        double dMax = rho + H;
+        double d = dMin + (dMax - dMin)*GetUnitRangeFromTextureCoord(2.0*muCoord - 1.0, SCATTERING_TEXTURE_MU_SIZE/2);
+        mu = (d == 0.0) ? 1.0 : ClampCosine((H*H - rho*rho - d*d)/(2.0*r*d));
+        rayIntersectsGround = false;
+    }
+
+    for (int column = 0; column < SCATTERING_TEXTURE_WIDTH; column++) {
+        int nuIndex = column/SCATTERING_TEXTURE_MU_S_SIZE;
+        int muSIndex = column % SCATTERING_TEXTURE_MU_S_SIZE;
+
+        // Sun zenith cosine
+        double xMuS = GetUnitRangeFromTextureCoord((muSIndex + 0.5)/SCATTERING_TEXTURE_MU_S_SIZE, SCATTERING_TEXTURE_MU_S_SIZE);
+        double dMin = top - bottom;
+        double dMax = H;
+        double D = DistanceToTop(bottom, parameters.muSMin);
+        double A = (D - dMin)/(dMax - dMin);
+        double a = (A - xMuS*A)/(1.0 + xMuS*A);
+        double d = dMin + std::min(a, A)*(dMax - dMin);
+        double muS = (d == 0.0) ? 1.0 : ClampCosine((H*H - d*d)/(2.0*bottom*d));
+
+        // View-sun angle cosine, limited to what the two zenith angles allow
+        double nu = ClampCosine((double)nuIndex/(SCATTERING_TEXTURE_NU_SIZE - 1)*2.0 - 1.0);
+        double spread = sqrt((1.0 - mu*mu)*(1.0 - muS*muS));
+        nu = std::max(mu*muS - spread, std::min(mu*muS + spread, nu));
+
+        // Single scattering along the view ray (trapezoidal rule)
+        double rayLength = rayIntersectsGround ? DistanceToBottom(r, mu) : DistanceToTop(r, mu);
+        double dx = rayLength/SCATTERING_SAMPLES;
+        double rayleighSum[3] = { 0.0, 0.0, 0.0 };
+        double mieSum[3] = { 0.0, 0.0, 0.0 };
+        for (int i = 0; i <= SCATTERING_SAMPLES; i++) {
+            double di = i*dx;
+            double rD = ClampRadius(sqrt(di*di + 2.0*r*mu*di + r*r));
+            double muSD = ClampCosine((r*muS + di*nu)/rD);
+
+            double viewTransmittance[3];
+            double sunTransmittance[3];
+            GetTransmittance(r, mu, di, rayIntersectsGround, viewTransmittance);
+            GetTransmittanceToSun(rD, muSD, sunTransmittance);
+
+            double weight = (i == 0 || i == SCATTERING_SAMPLES) ? 0.5 : 1.0;
+            double rayleighDensity = ProfileDensity(rD - bottom, parameters.rayleighScaleHeight)*weight;
+            double mieDensity = ProfileDensity(rD - bottom, parameters.mieScaleHeight)*weight;
+            for (int c = 0; c < 3; c++) {
+                double t = viewTransmittance[c]*sunTransmittance[c];
+                rayleighSum[c] += t*rayleighDensity;
+                mieSum[c] += t*mieDensity;
+            }
+        }
+
+        // Rayleigh in rgb, red Mie in alpha (the rest is extrapolated in the shader)
+        float* texel = &scattering[((size_t)row*SCATTERING_TEXTURE_WIDTH + column)*4];
+        for (int c = 0; c < 3; c++) {
+            texel[c] = (float)(rayleighSum[c]*dx*parameters.solarIrradiance[c]*parameters.rayleighScattering[c]);
+        }
+        texel[3] = (float)(mieSum[0]*dx*parameters.solarIrradiance[0]*parameters.mieScattering[0]);
+    }
+}
+
+void AtmosphereLUT::Bake(const AtmosphereParameters& newParameters, int threadCount) {
+    parameters = newParameters;
+    transmittance.assign((size_t)TRANSMITTANCE_TEXTURE_WIDTH*TRANSMITTANCE_TEXTURE_HEIGHT*4, 0.0f);
+    scattering.assign((size_t)SCATTERING_TEXTURE_WIDTH*SCATTERING_TEXTURE_HEIGHT*4, 0.0f);
+    threadCount = std::max(1, threadCount);
+
+    // Rows are handed out through a shared counter for load balancing
+    auto runRows = [this, threadCount](int rowCount, void (AtmosphereLUT::*computeRow)(int)) {
+        std::atomic<int> nextRow(0);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back([this, &nextRow, rowCount, computeRow]() {
+                for (int row = nextRow++; row < rowCount; row = nextRow++) {
+                    (this->*computeRow)(row);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    };
+
+    // Scattering samples the finished transmittance table
+    runRows(TRANSMITTANCE_TEXTURE_HEIGHT, &AtmosphereLUT::ComputeTransmittanceRow);
+    runRows(SCATTERING_TEXTURE_HEIGHT, &AtmosphereLUT::ComputeScatteringRow);
+}
+
+bool AtmosphereLUT::Save(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+
+    AtmosphereLUTHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "RSAT", 4);
+    header.version = ATMOSPHERE_LUT_VERSION;
+    header.transmittanceWidth = TRANSMITTANCE_TEXTURE_WIDTH;
+    header.transmittanceHeight = TRANSMITTANCE_TEXTURE_HEIGHT;
+    header.scatteringWidth = SCATTERING_TEXTURE_WIDTH;
+    header.scatteringHeight = SCATTERING_TEXTURE_HEIGHT;
+    header.parameters = parameters;
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(transmittance.data(), sizeof(float), transmittance.size(), file) == transmittance.size() &&
+                   fwrite(scattering.data(), sizeof(float), scattering.size(), file) == scattering.size();
+    fclose(file);
+    return success;
+}
+
+bool AtmosphereLUT::Load(const char* path, const AtmosphereParameters& expected) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return false;
+
+    // Reject caches from other versions, sizes or parameters
+    AtmosphereLUTHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, "RSAT", 4) == 0 &&
+                 header.version == ATMOSPHERE_LUT_VERSION &&
+                 header.transmittanceWidth == TRANSMITTANCE_TEXTURE_WIDTH &&
+                 header.transmittanceHeight == TRANSMITTANCE_TEXTURE_HEIGHT &&
+                 header.scatteringWidth == SCATTERING_TEXTURE_WIDTH &&
+                 header.scatteringHeight == SCATTERING_TEXTURE_HEIGHT &&
+                 memcmp(&header.parameters, &expected, sizeof(AtmosphereParameters)) == 0;
+
+    if (valid) {
+        transmittance.resize((size_t)TRANSMITTANCE_TEXTURE_WIDTH*TRANSMITTANCE_TEXTURE_HEIGHT*4);
+        scattering.resize((size_t)SCATTERING_TEXTURE_WIDTH*SCATTERING_TEXTURE_HEIGHT*4);
+        valid = fread(transmittance.data(), sizeof(float), transmittance.size(), file) == transmittance.size() &&
+                fread(scattering.data(), sizeof(float), scattering.size(), file) == scattering.size();
+    }
+    fclose(file);
+
+    if (valid) parameters = expected;
+    return valid;
+}
+
+const float* AtmosphereLUT::GetTransmittanceData() const {
+    return transmittance.data();
+}
+
+const float* AtmosphereLUT::GetScatteringData() const {
+    return scattering.data();
+}
+
+const AtmosphereParameters& AtmosphereLUT::GetParameters() const {
+    return parameters;
+}
@@ -0,0 +1,74 @@
+#ifndef ATMOSPHERE_LUT_H
+#define ATMOSPHERE_LUT_H
+
+#include <vector>
+
+// Lookup table sizes (must match atmosphere.fs and basic.fs)
+#define TRANSMITTANCE_TEXTURE_WIDTH 256
+#define TRANSMITTANCE_TEXTURE_HEIGHT 64
+#define SCATTERING_TEXTURE_R_SIZE 32
+#define SCATTERING_TEXTURE_MU_SIZE 128
+#define SCATTERING_TEXTURE_MU_S_SIZE 32
+#define SCATTERING_TEXTURE_NU_SIZE 8
+
+// The 4D scattering table is stored as a 2D texture: nu slices of mu_s
+// across, r slices of mu down
+#define SCATTERING_TEXTURE_WIDTH (SCATTERING_TEXTURE_NU_SIZE*SCATTERING_TEXTURE_MU_S_SIZE)
+#define SCATTERING_TEXTURE_HEIGHT (SCATTERING_TEXTURE_R_SIZE*SCATTERING_TEXTURE_MU_SIZE)
+
+// Physical description of an atmosphere, lengths in km
+struct AtmosphereParameters {
+    float bottomRadius;
+    float topRadius;
+    float rayleighScattering[3];    // Per km at sea level
+    float rayleighScaleHeight;
+    float mieScattering[3];
+    float mieExtinction[3];
+    float mieScaleHeight;
+    float miePhaseG;
+    float sunAngularRadius;         // Radians
+    float muSMin;                   // Cosine of the largest sun zenith angle stored
+    float solarIrradiance[3];
+};
+
+// Earth values from Bruneton's precomputed atmospheric scattering
+AtmosphereParameters GetEarthAtmosphereParameters();
+
+// Precomputed transmittance and single scattering tables, following
+// Bruneton's parameterization. Pure CPU code so it can be baked without
+// a window or GL context.
+class AtmosphereLUT {
+public:
+    // Constructor/Destructor
+    AtmosphereLUT();
+    ~AtmosphereLUT() = default;
+
+    // Compute both tables using threadCount threads
+    void Bake(const AtmosphereParameters& parameters, int threadCount);
+
+    // Disk cache, Load fails if the file was baked with other parameters
+    bool Save(const char* path) const;
+    bool Load(const char* path, const AtmosphereParameters& parameters);
+
+    // RGBA float data: transmittance, and rayleigh rgb + mie red scattering
+    const float* GetTransmittanceData() const;
+    const float* GetScatteringData() const;
+    const AtmosphereParameters& GetParameters() const;
+
+private:
+    AtmosphereParameters parameters;
+    std::vector<float> transmittance;
+    std::vector<float> scattering;
+
+    // Helper methods
+    void ComputeTransmittanceRow(int row);
+    void ComputeScatteringRow(int row);
+    void SampleTransmittance(double r, double mu, double result[3]) const;
+    void GetTransmittance(double r, double mu, double d, bool rayIntersectsGround, double result[3]) const;
+    void GetTransmittanceToSun(double r, double muS, double result[3]) const;
+    double DistanceToTop(double r, double mu) const;
+    double DistanceToBottom(double r, double mu) const;
+    double ClampRadius(double r) const;
+};
+
+#endif // ATMOSPHERE_LUT_H
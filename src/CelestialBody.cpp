@@ -1,4 +1,10 @@
 #include "CelestialBody.h"
+#include "Tools.h"
+#include "SphereMesh.h"
+
+// Same tessellation as sphere.glb
+#define SPHERE_RINGS 16
+#define SPHERE_SLICES 32
 
 CelestialBody::CelestialBody()
     : name("Unnamed"), 
@@ -9,6 +15,19 @@ CelestialBody::CelestialBody()
       position({0.0f, 0.0f, 0.0f}),
       rotationAxis({0.0f, 1.0f, 0.0f}), // Default rotation around Y axis
       isPaused(false),
+      preparedModel(MatrixIdentity()),
+      preparedMvp(MatrixIdentity()),
+      visible(true),
+      compactVertices(false),
+      textureResidency(nullptr),
+      diffuseHandle(INVALID_TEXTURE_HANDLE),
+      normalHandle(INVALID_TEXTURE_HANDLE),
+      specularHandle(INVALID_TEXTURE_HANDLE),
+      emissionHandle(INVALID_TEXTURE_HANDLE),
+      cloudHandle(INVALID_TEXTURE_HANDLE),
+      virtualTexture(nullptr),
+      atmosphere(nullptr),
+      clusteredLights(nullptr),
       hasCustomShader(false)
 {
     // Initialize all textures to empty
@@ -28,6 +47,19 @@ CelestialBody::CelestialBody(const std::string& name, float radius, float rotati
       position({0.0f, 0.0f, 0.0f}),
       rotationAxis({0.0f, 1.0f, 0.0f}), // Default rotation around Y axis
       isPaused(false),
+      preparedModel(MatrixIdentity()),
+      preparedMvp(MatrixIdentity()),
+      visible(true),
+      compactVertices(false),
+      textureResidency(nullptr),
+      diffuseHandle(INVALID_TEXTURE_HANDLE),
+      normalHandle(INVALID_TEXTURE_HANDLE),
+      specularHandle(INVALID_TEXTURE_HANDLE),
+      emissionHandle(INVALID_TEXTURE_HANDLE),
+      cloudHandle(INVALID_TEXTURE_HANDLE),
+      virtualTexture(nullptr),
+      atmosphere(nullptr),
+      clusteredLights(nullptr),
       hasCustomShader(false)
 {
     // Initialize all textures to empty
@@ -59,32 +91,32 @@ void CelestialBody::Initialize(const char* modelPath,
                              const char* emissionMapPath,
                              const char* cloudMapPath) {
     // Load model
-    model = LoadModel(modelPath);
+    if (modelPath != nullptr) {
+        model = LoadModel(modelPath);
+    } else {
+        model = LoadModelFromMesh(GenMeshCompactSphere(SPHERE_RINGS, SPHERE_SLICES));
+        compactVertices = true;
+    }
     
     // Load textures if paths are provided
     if (diffuseMapPath) {
-        diffuseTexture = LoadTexture(diffuseMapPath);
-        GenTextureMipmaps(&diffuseTexture);
+        LoadMap(diffuseMapPath, diffuseTexture, diffuseHandle);
     }
     
     if (normalMapPath) {
-        normalTexture = LoadTexture(normalMapPath);
-        GenTextureMipmaps(&normalTexture);
+        LoadMap(normalMapPath, normalTexture, normalHandle);
     }
     
     if (specularMapPath) {
-        specularTexture = LoadTexture(specularMapPath);
-        GenTextureMipmaps(&specularTexture);
+        LoadMap(specularMapPath, specularTexture, specularHandle);
     }
     
     if (emissionMapPath) {
-        emissionTexture = LoadTexture(emissionMapPath);
-        GenTextureMipmaps(&emissionTexture);
+        LoadMap(emissionMapPath, emissionTexture, emissionHandle);
     }
     
     if (cloudMapPath) {
-        cloudTexture = LoadTexture(cloudMapPath);
-        GenTextureMipmaps(&cloudTexture);
+        LoadMap(cloudMapPath, cloudTexture, cloudHandle);
     }
 
     // Initialize shader
@@ -139,6 +171,17 @@ void CelestialBody::Initialize(const char* modelPath,
     SetShaderValue(shader, hasCloudMapLoc, &hasCloudMap, SHADER_UNIFORM_INT);
 }
 
+void CelestialBody::LoadMap(const char* path, Texture2D& texture, TextureHandle& handle) {
+    if (textureResidency != nullptr) {
+        // Let the residency manager own and stream the texture
+        handle = textureResidency->Register(path);
+        texture = textureResidency->GetTexture(handle);
+    } else {
+        texture = LoadTexture(path);
+        GenTextureMipmaps(&texture);
+    }
+}
+
 void CelestialBody::SetCustomShader(Shader customShader) {
     // If we already had a custom shader, unload it
     if (hasCustomShader) {
@@ -171,6 +214,39 @@ void CelestialBody::SetupShaderLocations() {
     
     // Set cloud map texture location explicitly
     shader.locs[SHADER_LOC_MAP_DIFFUSE + 10] = cloudMapLoc; // Using a custom slot
+
+    // Virtual texture samplers use the otherwise unused 2D material slots
+    shader.locs[SHADER_LOC_MAP_ROUGHNESS] = GetShaderLocation(shader, "vtIndirection");
+    shader.locs[SHADER_LOC_MAP_OCCLUSION] = GetShaderLocation(shader, "vtPhysical");
+    hasVirtualTextureLoc = GetShaderLocation(shader, "hasVirtualTexture");
+    vtPageParamsLoc = GetShaderLocation(shader, "vtPageParams");
+    vtAtlasParamsLoc = GetShaderLocation(shader, "vtAtlasParams");
+    vtLayerParamsLoc = GetShaderLocation(shader, "vtLayerParams");
+
+    // Eclipse shadow uniforms
+    occluderCountLoc = GetShaderLocation(shader, "occluderCount");
+    occludersLoc = GetShaderLocation(shader, "occluders");
+    lightRadiusLoc = GetShaderLocation(shader, "lightRadius");
+
+    // Atmosphere transmittance table uses the height map slot
+    shader.locs[SHADER_LOC_MAP_HEIGHT] = GetShaderLocation(shader, "transmittanceLUT");
+    hasAtmosphereLoc = GetShaderLocation(shader, "hasAtmosphere");
+    planetCenterLoc = GetShaderLocation(shader, "planetCenter");
+    atmosphereRadiiLoc = GetShaderLocation(shader, "atmosphereRadii");
+
+    // Vertex format of the built-in sphere
+    compactVerticesLoc = GetShaderLocation(shader, "compactVertices");
+
+    // Clustered light data is bound past the material map units
+    hasClusteredLightsLoc = GetShaderLocation(shader, "hasClusteredLights");
+    clusterViewProjectionLoc = GetShaderLocation(shader, "clusterViewProjection");
+    clusterGridParamsLoc = GetShaderLocation(shader, "clusterGridParams");
+    clusterNearLoc = GetShaderLocation(shader, "clusterNear");
+    const char* clusterSamplers[] = { "clusterGrid", "clusterIndices", "clusterLights" };
+    for (int i = 0; i < 3; i++) {
+        int unit = CLUSTER_TEXTURE_UNIT + i;
+        SetShaderValue(shader, GetShaderLocation(shader, clusterSamplers[i]), &unit, SHADER_UNIFORM_INT);
+    }
 }
 
 void CelestialBody::Update(float deltaTime) {
@@ -195,7 +271,7 @@ void CelestialBody::UpdateOrbit(float deltaTime) {
     position = orbitSystem.GetOrbitalPosition();
 }
 
-void CelestialBody::Draw(const Camera3D& camera) {
+Matrix CelestialBody::ComputeModelMatrix() const {
     // Create rotation matrix for model
     Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle * DEG2RAD);
     
@@ -206,18 +282,50 @@ void CelestialBody::Draw(const Camera3D& camera) {
     Matrix matScale = MatrixScale(scale, scale, scale);
     
     // Create model matrix by combining rotation, scale and translation
-    Matrix matModel = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-    
-    // Set model matrix uniform
-    SetShaderValueMatrix(shader, modelLoc, matModel);
-    
-    // Calculate and set MVP matrix
-    Matrix matView = MatrixLookAt(camera.position, camera.target, camera.up);
-    Matrix matProjection = MatrixPerspective(camera.fovy*DEG2RAD, 
-                                           (float)GetScreenWidth()/(float)GetScreenHeight(),
-                                           0.1f, 100.0f);
-    Matrix mvp = MatrixMultiply(matView, matProjection);
-    SetShaderValueMatrix(shader, mvpLoc, mvp);
+    return MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
+}
+
+void CelestialBody::ComputeMatrices(const Camera3D& camera, Matrix& matModel, Matrix& mvp) const {
+    matModel = ComputeModelMatrix();
+
+    // Calculate MVP matrix (vertices are transformed to world space in the shader)
+    mvp = GetViewProjectionMatrix(camera);
+}
+
+void CelestialBody::PrepareDraw(const Matrix& viewProjection) {
+    preparedModel = ComputeModelMatrix();
+    preparedMvp = viewProjection;
+    visible = IsSphereInFrustum(viewProjection, position, radius);
+}
+
+bool CelestialBody::IsVisible() const {
+    return visible;
+}
+
+void CelestialBody::Draw() {
+    // Pick up textures that were re-uploaded at a different mip
+    if (textureResidency != nullptr) {
+        RefreshResidentTextures();
+    }
+
+    // Virtual texture maps are attached after Initialize
+    if (virtualTexture != nullptr) {
+        model.materials[0].maps[MATERIAL_MAP_ROUGHNESS].texture = virtualTexture->GetIndirectionTexture();
+        model.materials[0].maps[MATERIAL_MAP_OCCLUSION].texture = virtualTexture->GetPhysicalTexture();
+    }
+
+    if (atmosphere != nullptr) {
+        model.materials[0].maps[MATERIAL_MAP_HEIGHT].texture = atmosphere->GetTransmittanceTexture();
+    }
+
+    // Cluster data lives outside the material maps, DrawModel leaves it bound
+    if (clusteredLights != nullptr && clusteredLights->IsLoaded()) {
+        clusteredLights->Bind();
+    }
+
+    // Set model and MVP matrix uniforms
+    SetShaderValueMatrix(shader, modelLoc, preparedModel);
+    SetShaderValueMatrix(shader, mvpLoc, preparedMvp);
     
     // Update cloud texture binding explicitly if we have clouds
     if (cloudTexture.id > 0) {
@@ -246,6 +354,81 @@ void CelestialBody::UpdateShaderValues(const Camera3D& camera, const Vector3& li
     SetShaderValue(shader, hasSpecularMapLoc, &hasSpecularMap, SHADER_UNIFORM_INT);
     SetShaderValue(shader, hasEmissionMapLoc, &hasEmissionMap, SHADER_UNIFORM_INT);
     SetShaderValue(shader, hasCloudMapLoc, &hasCloudMap, SHADER_UNIFORM_INT);
+
+    int hasCompactVertices = compactVertices;
+    SetShaderValue(shader, compactVerticesLoc, &hasCompactVertices, SHADER_UNIFORM_INT);
+
+    // Virtual texture layout
+    int hasVirtualTexture = (virtualTexture != nullptr && virtualTexture->IsLoaded());
+    SetShaderValue(shader, hasVirtualTextureLoc, &hasVirtualTexture, SHADER_UNIFORM_INT);
+    if (hasVirtualTexture) {
+        Vector4 pageParams = virtualTexture->GetPageParams();
+        Vector4 atlasParams = virtualTexture->GetAtlasParams();
+        Vector2 layerParams = virtualTexture->GetLayerParams();
+        SetShaderValue(shader, vtPageParamsLoc, &pageParams, SHADER_UNIFORM_VEC4);
+        SetShaderValue(shader, vtAtlasParamsLoc, &atlasParams, SHADER_UNIFORM_VEC4);
+        SetShaderValue(shader, vtLayerParamsLoc, &layerParams, SHADER_UNIFORM_VEC2);
+    }
+
+    // Atmosphere scale, the surface sits at the bottom radius
+    int hasAtmosphere = (atmosphere != nullptr && atmosphere->IsLoaded());
+    SetShaderValue(shader, hasAtmosphereLoc, &hasAtmosphere, SHADER_UNIFORM_INT);
+    if (hasAtmosphere) {
+        const AtmosphereParameters& parameters = atmosphere->GetParameters();
+        Vector3 radii = { parameters.bottomRadius, parameters.topRadius, parameters.bottomRadius/radius };
+        SetShaderValue(shader, planetCenterLoc, &position, SHADER_UNIFORM_VEC3);
+        SetShaderValue(shader, atmosphereRadiiLoc, &radii, SHADER_UNIFORM_VEC3);
+    }
+
+    // Cluster layout of the last light binning
+    int hasClusteredLights = (clusteredLights != nullptr && clusteredLights->IsLoaded() && clusteredLights->GetLightCount() > 0);
+    SetShaderValue(shader, hasClusteredLightsLoc, &hasClusteredLights, SHADER_UNIFORM_INT);
+    if (hasClusteredLights) {
+        Vector4 gridParams = clusteredLights->GetGridParams();
+        float clusterNear = SCENE_NEAR_PLANE;
+        SetShaderValueMatrix(shader, clusterViewProjectionLoc, clusteredLights->GetViewProjection());
+        SetShaderValue(shader, clusterGridParamsLoc, &gridParams, SHADER_UNIFORM_VEC4);
+        SetShaderValue(shader, clusterNearLoc, &clusterNear, SHADER_UNIFORM_FLOAT);
+    }
+}
+
+void CelestialBody::UpdateShadowOccluders(const Vector4* occluders, int count, float lightRadius) {
+    Vector4 nearest[MAX_SHADOW_OCCLUDERS];
+    float nearestDistance[MAX_SHADOW_OCCLUDERS];
+    int nearestCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        Vector3 center = { occluders[i].x, occluders[i].y, occluders[i].z };
+        float distance = Vector3DistanceSqr(center, position);
+
+        // Our own sphere is handled by N.L
+        if (distance < 1e-8f) continue;
+
+        // Insertion into the sorted nearest list
+        int slot = nearestCount;
+        while (slot > 0 && nearestDistance[slot - 1] > distance) {
+            if (slot < MAX_SHADOW_OCCLUDERS) {
+                nearest[slot] = nearest[slot - 1];
+                nearestDistance[slot] = nearestDistance[slot - 1];
+            }
+            slot--;
+        }
+        if (slot < MAX_SHADOW_OCCLUDERS) {
+            nearest[slot] = occluders[i];
+            nearestDistance[slot] = distance;
+            if (nearestCount < MAX_SHADOW_OCCLUDERS) nearestCount++;
+        }
+    }
+
+    SetShaderValue(shader, occluderCountLoc, &nearestCount, SHADER_UNIFORM_INT);
+    if (nearestCount > 0) {
+        SetShaderValueV(shader, occludersLoc, nearest, SHADER_UNIFORM_VEC4, nearestCount);
+    }
+    SetShaderValue(shader, lightRadiusLoc, &lightRadius, SHADER_UNIFORM_FLOAT);
+}
+
+const std::string& CelestialBody::GetName() const {
+    return name;
 }
 
 void CelestialBody::SetPosition(const Vector3& newPosition) {
@@ -256,6 +439,14 @@ Vector3 CelestialBody::GetPosition() const {
     return position;
 }
 
+Quaternion CelestialBody::GetOrientation() const {
+    return QuaternionFromAxisAngle(rotationAxis, rotationAngle * DEG2RAD);
+}
+
+float CelestialBody::GetRadius() const {
+    return radius;
+}
+
 void CelestialBody::SetRotationAxis(const Vector3& axis) {
     rotationAxis = axis;
 }
@@ -269,7 +460,78 @@ void CelestialBody::SetOrbit(CelestialBody* parent, float distance, float speed,
     orbitSystem.SetOrbit(parent, distance, speed, tilt);
 }
 
+void CelestialBody::SetTextureResidency(TextureResidency* residency) {
+    textureResidency = residency;
+}
+
+float CelestialBody::GetProjectedDiameter(const Camera3D& camera, int viewportHeight) const {
+    float distance = Vector3Distance(camera.position, position);
+    if (distance <= radius) return (float)viewportHeight;
+
+    // Angular diameter of the sphere relative to the vertical field of view
+    float angularDiameter = 2.0f*asinf(radius/distance);
+    return angularDiameter/(camera.fovy*DEG2RAD)*(float)viewportHeight;
+}
+
+void CelestialBody::UpdateTextureResidency(const Camera3D& camera, int viewportHeight) {
+    if (textureResidency == nullptr) return;
+
+    // Around half of an equirectangular map wraps the visible disk, and the
+    // disk center shows it at PI/2 texels per pixel along the equator
+    float requiredWidth = GetProjectedDiameter(camera, viewportHeight)*PI;
+
+    textureResidency->RequestWidth(diffuseHandle, requiredWidth);
+    textureResidency->RequestWidth(normalHandle, requiredWidth);
+    textureResidency->RequestWidth(specularHandle, requiredWidth);
+    textureResidency->RequestWidth(emissionHandle, requiredWidth);
+    textureResidency->RequestWidth(cloudHandle, requiredWidth);
+}
+
+void CelestialBody::RefreshResidentTextures() {
+    diffuseTexture = textureResidency->GetTexture(diffuseHandle);
+    normalTexture = textureResidency->GetTexture(normalHandle);
+    specularTexture = textureResidency->GetTexture(specularHandle);
+    emissionTexture = textureResidency->GetTexture(emissionHandle);
+    cloudTexture = textureResidency->GetTexture(cloudHandle);
+
+    model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = diffuseTexture;
+    model.materials[0].maps[MATERIAL_MAP_NORMAL].texture = normalTexture;
+    model.materials[0].maps[MATERIAL_MAP_SPECULAR].texture = specularTexture;
+    model.materials[0].maps[MATERIAL_MAP_EMISSION].texture = emissionTexture;
+    model.materials[0].maps[10].texture = cloudTexture;
+}
+
+void CelestialBody::SetVirtualTexture(VirtualTexture* texture) {
+    virtualTexture = texture;
+}
+
+void CelestialBody::SetAtmosphere(Atmosphere* newAtmosphere) {
+    atmosphere = newAtmosphere;
+}
+
+void CelestialBody::SetClusteredLights(ClusteredLights* lights) {
+    clusteredLights = lights;
+}
+
+void CelestialBody::DrawVirtualTextureFeedback(const Camera3D& camera, VirtualTextureFeedback& feedback, int textureId) {
+    if (virtualTexture == nullptr || !virtualTexture->IsLoaded()) return;
+
+    Matrix matModel;
+    Matrix mvp;
+    ComputeMatrices(camera, matModel, mvp);
+    feedback.SetBody(*virtualTexture, textureId, matModel, mvp);
+
+    // Draw the same geometry with the feedback shader
+    Shader bodyShader = model.materials[0].shader;
+    model.materials[0].shader = feedback.GetShader();
+    DrawModel(model, Vector3Zero(), 1.0f, WHITE);
+    model.materials[0].shader = bodyShader;
+}
+
 void CelestialBody::UnloadTextures() {
+    // Streamed textures belong to the residency manager
+    if (textureResidency != nullptr) return;
+
     if (diffuseTexture.id > 0) UnloadTexture(diffuseTexture);
     if (normalTexture.id > 0) UnloadTexture(normalTexture);
     if (specularTexture.id > 0) UnloadTexture(specularTexture);
@@ -4,9 +4,16 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "OrbitSystem.h"
+#include "TextureResidency.h"
+#include "VirtualTexture.h"
+#include "Atmosphere.h"
+#include "ClusteredLights.h"
 #include <string>
 #include <memory>
 
+// Must match MAX_OCCLUDERS in basic.fs
+#define MAX_SHADOW_OCCLUDERS 8
+
 class CelestialBody {
 public:
     // Constructor/Destructor
@@ -14,7 +21,8 @@ public:
     CelestialBody(const std::string& name, float radius, float rotationSpeed);
     ~CelestialBody();
 
-    // Initialize celestial body with model and textures
+    // Initialize celestial body with model and textures, a null modelPath
+    // uses the built-in compact sphere mesh
     void Initialize(const char* modelPath,
                   const char* diffuseMapPath,
                   const char* normalMapPath = nullptr,
@@ -27,12 +35,20 @@ public:
     void SetPaused(bool paused);
     bool IsPaused() const;
 
-    // Draw the celestial body
-    void Draw(const Camera3D& camera);
+    // Compose the transforms used by Draw and test the bounding sphere
+    // against the view. Only touches this body, so it can run on a worker.
+    void PrepareDraw(const Matrix& viewProjection);
+    bool IsVisible() const;
+
+    // Draw the celestial body with the transforms from PrepareDraw
+    void Draw();
 
     // Position and orientation setters/getters
+    const std::string& GetName() const;
     void SetPosition(const Vector3& position);
     Vector3 GetPosition() const;
+    Quaternion GetOrientation() const;
+    float GetRadius() const;
     void SetRotationAxis(const Vector3& axis);
     void SetScale(float scale);    // Orbit related methods
     void SetOrbit(CelestialBody* parent, float orbitDistance, float orbitSpeed, float orbitTilt);
@@ -51,6 +67,25 @@ public:
     void SetCustomShader(Shader shader);
     void UpdateShaderValues(const Camera3D& camera, const Vector3& lightPos);
 
+    // Eclipse shadows: spheres (center xyz, radius w) that can block the light.
+    // The body skips itself and keeps the nearest MAX_SHADOW_OCCLUDERS.
+    void UpdateShadowOccluders(const Vector4* occluders, int count, float lightRadius);
+
+    // Texture streaming (call SetTextureResidency before Initialize)
+    void SetTextureResidency(TextureResidency* residency);
+    void UpdateTextureResidency(const Camera3D& camera, int viewportHeight);
+    float GetProjectedDiameter(const Camera3D& camera, int viewportHeight) const;
+
+    // Virtual texturing (replaces the diffuse and normal maps when set)
+    void SetVirtualTexture(VirtualTexture* texture);
+    void DrawVirtualTextureFeedback(const Camera3D& camera, VirtualTextureFeedback& feedback, int textureId);
+
+    // Atmosphere that filters sunlight reaching the surface, owned by the caller
+    void SetAtmosphere(Atmosphere* atmosphere);
+
+    // Local lights binned into view clusters, owned by the caller
+    void SetClusteredLights(ClusteredLights* lights);
+
 private:
     std::string name;
     float radius;
@@ -60,17 +95,40 @@ private:
     Vector3 position;
     Vector3 rotationAxis;
     bool isPaused;
+
+    // Prepared for the next draw
+    Matrix preparedModel;
+    Matrix preparedMvp;
+    bool visible;
     
     // Orbit system
     OrbitSystem orbitSystem;
     
     // 3D model and textures
     Model model;
+    bool compactVertices;
     Texture2D diffuseTexture;
     Texture2D normalTexture;
     Texture2D specularTexture;
     Texture2D emissionTexture;
     Texture2D cloudTexture;
+
+    // Streamed textures, owned by the residency manager when set
+    TextureResidency* textureResidency;
+    TextureHandle diffuseHandle;
+    TextureHandle normalHandle;
+    TextureHandle specularHandle;
+    TextureHandle emissionHandle;
+    TextureHandle cloudHandle;
+
+    // Virtual texture, owned by the caller
+    VirtualTexture* virtualTexture;
+
+    // Atmosphere, owned by the caller
+    Atmosphere* atmosphere;
+
+    // Local lights, owned by the caller
+    ClusteredLights* clusteredLights;
     
     // Shader data
     Shader shader;
@@ -89,10 +147,29 @@ private:
     int hasSpecularMapLoc;
     int hasEmissionMapLoc;
     int hasCloudMapLoc;
+    int hasVirtualTextureLoc;
+    int vtPageParamsLoc;
+    int vtAtlasParamsLoc;
+    int vtLayerParamsLoc;
+    int occluderCountLoc;
+    int occludersLoc;
+    int lightRadiusLoc;
+    int hasAtmosphereLoc;
+    int planetCenterLoc;
+    int atmosphereRadiiLoc;
+    int compactVerticesLoc;
+    int hasClusteredLightsLoc;
+    int clusterViewProjectionLoc;
+    int clusterGridParamsLoc;
+    int clusterNearLoc;
 
 
     // Helper methods
     void UnloadTextures();
+    void LoadMap(const char* path, Texture2D& texture, TextureHandle& handle);
+    void RefreshResidentTextures();
+    Matrix ComputeModelMatrix() const;
+    void ComputeMatrices(const Camera3D& camera, Matrix& matModel, Matrix& mvp) const;
     void SetupShaderLocations();
 };
 
@@ -0,0 +1,246 @@
+#include "ClusteredLights.h"
+#include "Tools.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Data texture read with texelFetch, so no filtering or mipmaps
+static Texture2D LoadDataTexture(int width, int height, int format) {
+    Texture2D texture = { 0 };
+    texture.id = rlLoadTexture(nullptr, width, height, format, 1);
+    texture.width = width;
+    texture.height = height;
+    texture.mipmaps = 1;
+    texture.format = format;
+    if (texture.id > 0) {
+        SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+        SetTextureWrap(texture, TEXTURE_WRAP_CLAMP);
+    }
+    return texture;
+}
+
+ClusteredLights::ClusteredLights()
+    : lights(MAX_CLUSTERED_LIGHTS),
+      viewLights(MAX_CLUSTERED_LIGHTS),
+      clusterCounts(CLUSTER_COUNT, 0),
+      clusterLights((size_t)CLUSTER_COUNT*MAX_LIGHTS_PER_CLUSTER),
+      gridData((size_t)CLUSTER_COUNT*4, 0.0f),
+      indexData(MAX_CLUSTER_INDICES, 0.0f),
+      lightPositions(MAX_CLUSTERED_LIGHTS),
+      lightColors(MAX_CLUSTERED_LIGHTS),
+      lightCount(0),
+      indexCount(0),
+      maxClusterLights(0),
+      droppedCount(0),
+      buildMilliseconds(0.0f),
+      viewProjection(MatrixIdentity()),
+      tileScaleX(1.0f),
+      tileScaleY(1.0f)
+{
+    gridTexture = { 0 };
+    indexTexture = { 0 };
+    lightTexture = { 0 };
+}
+
+ClusteredLights::~ClusteredLights() {
+    Unload();
+}
+
+bool ClusteredLights::Load() {
+    Unload();
+
+    gridTexture = LoadDataTexture(CLUSTER_GRID_X*CLUSTER_GRID_Y, CLUSTER_GRID_Z, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+    indexTexture = LoadDataTexture(CLUSTER_INDEX_WIDTH, MAX_CLUSTER_INDICES/CLUSTER_INDEX_WIDTH, PIXELFORMAT_UNCOMPRESSED_R32);
+    lightTexture = LoadDataTexture(MAX_CLUSTERED_LIGHTS, 2, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+    if (gridTexture.id == 0 || indexTexture.id == 0 || lightTexture.id == 0) {
+        TraceLog(LOG_WARNING, "CLUSTER: Failed to create light data textures");
+        Unload();
+        return false;
+    }
+
+    // Start with empty clusters
+    UpdateTexture(gridTexture, gridData.data());
+    return true;
+}
+
+void ClusteredLights::Unload() {
+    if (gridTexture.id > 0) UnloadTexture(gridTexture);
+    if (indexTexture.id > 0) UnloadTexture(indexTexture);
+    if (lightTexture.id > 0) UnloadTexture(lightTexture);
+    gridTexture = { 0 };
+    indexTexture = { 0 };
+    lightTexture = { 0 };
+}
+
+bool ClusteredLights::IsLoaded() const {
+    return gridTexture.id > 0;
+}
+
+void ClusteredLights::SetLights(const PointLight* newLights, int count) {
+    lightCount = std::min(std::max(count, 0), MAX_CLUSTERED_LIGHTS);
+    std::copy(newLights, newLights + lightCount, lights.begin());
+}
+
+void ClusteredLights::Build(const Camera3D& camera, float aspect, JobSystem& jobSystem) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Same projection as the bodies (see GetViewProjectionMatrix)
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection = MatrixPerspective(camera.fovy*DEG2RAD, aspect, SCENE_NEAR_PLANE, SCENE_FAR_PLANE);
+    viewProjection = MatrixMultiply(view, projection);
+    tileScaleX = 1.0f/projection.m0;
+    tileScaleY = 1.0f/projection.m5;
+
+    for (int i = 0; i < lightCount; i++) {
+        Vector3 center = Vector3Transform(lights[i].position, view);
+        viewLights[i] = Vector4{ center.x, center.y, center.z, lights[i].range };
+    }
+
+    // Slices write disjoint clusters, so they bin in parallel without locks
+    if (lightCount > 0) {
+        jobSystem.ParallelFor(0, CLUSTER_GRID_Z, 1, [this](int first, int last) {
+            for (int slice = first; slice < last; slice++) {
+                BinSlice(slice);
+            }
+        });
+    } else {
+        std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+    }
+
+    // Pack the per-cluster lists into one index list
+    indexCount = 0;
+    maxClusterLights = 0;
+    droppedCount = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        int count = std::min(clusterCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+        count = std::min(count, MAX_CLUSTER_INDICES - indexCount);
+        droppedCount += clusterCounts[cluster] - count;
+        maxClusterLights = std::max(maxClusterLights, clusterCounts[cluster]);
+
+        const unsigned short* list = &clusterLights[(size_t)cluster*MAX_LIGHTS_PER_CLUSTER];
+        for (int i = 0; i < count; i++) {
+            indexData[indexCount + i] = (float)list[i];
+        }
+        gridData[cluster*4 + 0] = (float)indexCount;
+        gridData[cluster*4 + 1] = (float)count;
+        indexCount += count;
+    }
+
+    for (int i = 0; i < lightCount; i++) {
+        const PointLight& light = lights[i];
+        lightPositions[i] = Vector4{ light.position.x, light.position.y, light.position.z, light.range };
+        lightColors[i] = Vector4{ light.color.x*light.intensity, light.color.y*light.intensity, light.color.z*light.intensity, 1.0f };
+    }
+
+    buildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ClusteredLights::BinSlice(int slice) {
+    // Exponential slices keep froxels roughly cubic along the view
+    float depthRatio = SCENE_FAR_PLANE/SCENE_NEAR_PLANE;
+    float nearDepth = SCENE_NEAR_PLANE*powf(depthRatio, (float)slice/CLUSTER_GRID_Z);
+    float farDepth = SCENE_NEAR_PLANE*powf(depthRatio, (float)(slice + 1)/CLUSTER_GRID_Z);
+
+    // Lights reaching into this slice
+    unsigned short sliceLights[MAX_CLUSTERED_LIGHTS];
+    int sliceCount = 0;
+    for (int i = 0; i < lightCount; i++) {
+        float depth = -viewLights[i].z;
+        if (depth + viewLights[i].w >= nearDepth && depth - viewLights[i].w <= farDepth) {
+            sliceLights[sliceCount++] = (unsigned short)i;
+        }
+    }
+
+    for (int y = 0; y < CLUSTER_GRID_Y; y++) {
+        float ndcMinY = -1.0f + 2.0f*y/CLUSTER_GRID_Y;
+        float ndcMaxY = -1.0f + 2.0f*(y + 1)/CLUSTER_GRID_Y;
+        float minY = std::min(ndcMinY*nearDepth, ndcMinY*farDepth)*tileScaleY;
+        float maxY = std::max(ndcMaxY*nearDepth, ndcMaxY*farDepth)*tileScaleY;
+
+        // Lights reaching into this row of the slice
+        unsigned short rowLights[MAX_CLUSTERED_LIGHTS];
+        int rowCount = 0;
+        for (int i = 0; i < sliceCount; i++) {
+            const Vector4& light = viewLights[sliceLights[i]];
+            float dy = light.y - std::min(std::max(light.y, minY), maxY);
+            float dz = light.z - std::min(std::max(light.z, -farDepth), -nearDepth);
+            if (dy*dy + dz*dz <= light.w*light.w) rowLights[rowCount++] = sliceLights[i];
+        }
+
+        for (int x = 0; x < CLUSTER_GRID_X; x++) {
+            float ndcMinX = -1.0f + 2.0f*x/CLUSTER_GRID_X;
+            float ndcMaxX = -1.0f + 2.0f*(x + 1)/CLUSTER_GRID_X;
+            float minX = std::min(ndcMinX*nearDepth, ndcMinX*farDepth)*tileScaleX;
+            float maxX = std::max(ndcMaxX*nearDepth, ndcMaxX*farDepth)*tileScaleX;
+
+            // View-space box around the froxel against each light sphere
+            int cluster = x + y*CLUSTER_GRID_X + slice*CLUSTER_GRID_X*CLUSTER_GRID_Y;
+            unsigned short* list = &clusterLights[(size_t)cluster*MAX_LIGHTS_PER_CLUSTER];
+            int count = 0;
+            for (int i = 0; i < rowCount; i++) {
+                const Vector4& light = viewLights[rowLights[i]];
+                float dx = light.x - std::min(std::max(light.x, minX), maxX);
+                float dy = light.y - std::min(std::max(light.y, minY), maxY);
+                float dz = light.z - std::min(std::max(light.z, -farDepth), -nearDepth);
+                if (dx*dx + dy*dy + dz*dz > light.w*light.w) continue;
+
+                if (count < MAX_LIGHTS_PER_CLUSTER) list[count] = rowLights[i];
+                count++;
+            }
+            clusterCounts[cluster] = count;
+        }
+    }
+}
+
+void ClusteredLights::Upload() {
+    if (!IsLoaded()) return;
+
+    UpdateTexture(gridTexture, gridData.data());
+    if (indexCount > 0) {
+        int rows = (indexCount + CLUSTER_INDEX_WIDTH - 1)/CLUSTER_INDEX_WIDTH;
+        UpdateTextureRec(indexTexture, Rectangle{ 0, 0, (float)CLUSTER_INDEX_WIDTH, (float)rows }, indexData.data());
+    }
+    if (lightCount > 0) {
+        UpdateTextureRec(lightTexture, Rectangle{ 0, 0, (float)lightCount, 1 }, lightPositions.data());
+        UpdateTextureRec(lightTexture, Rectangle{ 0, 1, (float)lightCount, 1 }, lightColors.data());
+    }
+}
+
+void ClusteredLights::Bind() const {
+    rlActiveTextureSlot(CLUSTER_TEXTURE_UNIT);
+    rlEnableTexture(gridTexture.id);
+    rlActiveTextureSlot(CLUSTER_TEXTURE_UNIT + 1);
+    rlEnableTexture(indexTexture.id);
+    rlActiveTextureSlot(CLUSTER_TEXTURE_UNIT + 2);
+    rlEnableTexture(lightTexture.id);
+    rlActiveTextureSlot(0);
+}
+
+const Matrix& ClusteredLights::GetViewProjection() const {
+    return viewProjection;
+}
+
+Vector4 ClusteredLights::GetGridParams() const {
+    return Vector4{ (float)CLUSTER_GRID_X, (float)CLUSTER_GRID_Y, (float)CLUSTER_GRID_Z,
+                    logf(SCENE_FAR_PLANE/SCENE_NEAR_PLANE) };
+}
+
+int ClusteredLights::GetLightCount() const {
+    return lightCount;
+}
+
+int ClusteredLights::GetIndexCount() const {
+    return indexCount;
+}
+
+int ClusteredLights::GetMaxClusterLights() const {
+    return maxClusterLights;
+}
+
+int ClusteredLights::GetDroppedCount() const {
+    return droppedCount;
+}
+
+float ClusteredLights::GetBuildMilliseconds() const {
+    return buildMilliseconds;
+}
@@ -0,0 +1,97 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include "raylib.h"
+#include "JobSystem.h"
+#include <vector>
+
+// Froxel grid: screen tiles by exponential depth slices. Must match the
+// grid size set through clusterGridParams in basic.fs.
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT (CLUSTER_GRID_X*CLUSTER_GRID_Y*CLUSTER_GRID_Z)
+
+#define MAX_CLUSTERED_LIGHTS 1024
+#define MAX_LIGHTS_PER_CLUSTER 64
+#define CLUSTER_INDEX_WIDTH 1024
+#define MAX_CLUSTER_INDICES (CLUSTER_INDEX_WIDTH*64)
+
+// First texture unit of the cluster data, after the material map units
+#define CLUSTER_TEXTURE_UNIT 12
+
+// Point light with a smooth falloff that reaches zero at range
+struct PointLight {
+    Vector3 position;
+    float range;
+    Vector3 color;
+    float intensity;
+};
+
+// Clustered forward lighting. Every frame the lights are binned on the CPU
+// into view-space froxels, one job per depth slice, and the per-cluster
+// light lists are uploaded to data textures. A fragment finds its cluster
+// from its clip position and only shades the lights listed there.
+class ClusteredLights {
+public:
+    // Constructor/Destructor
+    ClusteredLights();
+    ~ClusteredLights();
+
+    // Create the data textures
+    bool Load();
+    void Unload();
+    bool IsLoaded() const;
+
+    // Lights for the next Build, at most MAX_CLUSTERED_LIGHTS are used
+    void SetLights(const PointLight* lights, int count);
+
+    // Bin the lights for the view. CPU only, so it can run as a job.
+    void Build(const Camera3D& camera, float aspect, JobSystem& jobSystem);
+
+    // Upload the light and cluster data of the last Build (main thread)
+    void Upload();
+
+    // Bind the data textures to CLUSTER_TEXTURE_UNIT and the next two units
+    void Bind() const;
+
+    // View of the last Build, used by the shader to find clusters
+    const Matrix& GetViewProjection() const;
+    Vector4 GetGridParams() const;      // Clusters x, y, z, log(far/near)
+
+    // Statistics of the last Build
+    int GetLightCount() const;
+    int GetIndexCount() const;
+    int GetMaxClusterLights() const;
+    int GetDroppedCount() const;        // Lights cut from full clusters
+    float GetBuildMilliseconds() const;
+
+private:
+    Texture2D gridTexture;      // Offset and count per cluster
+    Texture2D indexTexture;     // Light indices of all clusters
+    Texture2D lightTexture;     // Position and range, then color per light
+
+    // Frame state, sized once so binning does not allocate
+    std::vector<PointLight> lights;
+    std::vector<Vector4> viewLights;            // View-space center, range
+    std::vector<int> clusterCounts;
+    std::vector<unsigned short> clusterLights;  // MAX_LIGHTS_PER_CLUSTER per cluster
+    std::vector<float> gridData;
+    std::vector<float> indexData;
+    std::vector<Vector4> lightPositions;
+    std::vector<Vector4> lightColors;
+    int lightCount;
+    int indexCount;
+    int maxClusterLights;
+    int droppedCount;
+    float buildMilliseconds;
+
+    Matrix viewProjection;
+    float tileScaleX;           // View-space x per NDC x at depth 1
+    float tileScaleY;
+
+    // Helper methods
+    void BinSlice(int slice);
+};
+
+#endif // CLUSTERED_LIGHTS_H
@@ -0,0 +1,450 @@
+#include "DynamicBVH.h"
+#include "raymath.h"
+#include <algorithm>
+#include <cfloat>
+
+// Traversal stack kept on the call stack, deeper trees spill to the heap
+#define NODE_STACK_SIZE 256
+
+class NodeStack {
+public:
+    NodeStack() : count(0) {}
+
+    void Push(int node) {
+        if (count < NODE_STACK_SIZE) fixed[count] = node;
+        else overflow.push_back(node);
+        count++;
+    }
+
+    int Pop() {
+        count--;
+        if (count < NODE_STACK_SIZE) return fixed[count];
+        int node = overflow.back();
+        overflow.pop_back();
+        return node;
+    }
+
+    bool IsEmpty() const { return count == 0; }
+    void Clear() { count = 0; overflow.clear(); }
+
+private:
+    int fixed[NODE_STACK_SIZE];
+    std::vector<int> overflow;
+    int count;
+};
+
+static BoundingBox BoxUnion(const BoundingBox& a, const BoundingBox& b) {
+    return BoundingBox{ Vector3Min(a.min, b.min), Vector3Max(a.max, b.max) };
+}
+
+// Surface area heuristic cost of a box
+static float BoxArea(const BoundingBox& box) {
+    Vector3 size = Vector3Subtract(box.max, box.min);
+    return 2.0f*(size.x*size.y + size.y*size.z + size.z*size.x);
+}
+
+static bool BoxContains(const BoundingBox& outer, const BoundingBox& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+// Slab test, returns the entry distance or -1 when the ray misses
+static float RayBoxDistance(const Ray& ray, const BoundingBox& box, float maxDistance) {
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    const float origin[3] = { ray.position.x, ray.position.y, ray.position.z };
+    const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    const float boxMin[3] = { box.min.x, box.min.y, box.min.z };
+    const float boxMax[3] = { box.max.x, box.max.y, box.max.z };
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (fabsf(direction[axis]) < 1e-8f) {
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) return -1.0f;
+            continue;
+        }
+        float inverse = 1.0f/direction[axis];
+        float t1 = (boxMin[axis] - origin[axis])*inverse;
+        float t2 = (boxMax[axis] - origin[axis])*inverse;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return -1.0f;
+    }
+    return tMin;
+}
+
+DynamicBVH::DynamicBVH()
+    : root(INVALID_PROXY),
+      freeList(INVALID_PROXY),
+      proxyCount(0),
+      reinsertCount(0),
+      margin(0.1f)
+{
+}
+
+int DynamicBVH::AllocateNode() {
+    int node;
+    if (freeList != INVALID_PROXY) {
+        node = freeList;
+        freeList = nodes[node].parent;
+    } else {
+        node = (int)nodes.size();
+        nodes.push_back(Node());
+    }
+
+    nodes[node].box = BoundingBox{ Vector3Zero(), Vector3Zero() };
+    nodes[node].center = Vector3Zero();
+    nodes[node].radius = 0.0f;
+    nodes[node].parent = INVALID_PROXY;
+    nodes[node].child1 = INVALID_PROXY;
+    nodes[node].child2 = INVALID_PROXY;
+    nodes[node].height = 0;
+    nodes[node].userData = -1;
+    return node;
+}
+
+void DynamicBVH::FreeNode(int node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+BoundingBox DynamicBVH::FatBox(const Vector3& center, float radius) const {
+    float extent = radius + margin;
+    return BoundingBox{ Vector3Subtract(center, Vector3{ extent, extent, extent }),
+                        Vector3Add(center, Vector3{ extent, extent, extent }) };
+}
+
+int DynamicBVH::CreateProxy(const Vector3& center, float radius, int userData) {
+    int proxy = AllocateNode();
+    nodes[proxy].box = FatBox(center, radius);
+    nodes[proxy].center = center;
+    nodes[proxy].radius = radius;
+    nodes[proxy].userData = userData;
+
+    InsertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void DynamicBVH::DestroyProxy(int proxy) {
+    if (proxy < 0 || proxy >= (int)nodes.size() || nodes[proxy].height != 0) return;
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxyCount--;
+}
+
+bool DynamicBVH::MoveProxy(int proxy, const Vector3& center, float radius) {
+    if (proxy < 0 || proxy >= (int)nodes.size() || nodes[proxy].height != 0) return false;
+
+    nodes[proxy].center = center;
+    nodes[proxy].radius = radius;
+
+    // Still inside its fat box, and the box did not become far too large
+    BoundingBox tight = { Vector3Subtract(center, Vector3{ radius, radius, radius }),
+                          Vector3Add(center, Vector3{ radius, radius, radius }) };
+    BoundingBox fat = nodes[proxy].box;
+    if (BoxContains(fat, tight) && fat.max.x - fat.min.x <= 2.0f*(radius + 4.0f*margin)) return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].box = FatBox(center, radius);
+    InsertLeaf(proxy);
+    reinsertCount++;
+    return true;
+}
+
+int DynamicBVH::GetUserData(int proxy) const {
+    return nodes[proxy].userData;
+}
+
+void DynamicBVH::InsertLeaf(int leaf) {
+    if (root == INVALID_PROXY) {
+        root = leaf;
+        nodes[root].parent = INVALID_PROXY;
+        return;
+    }
+
+    // Walk down to the sibling with the lowest surface area cost
+    BoundingBox leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].IsLeaf()) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = BoxArea(nodes[index].box);
+        float combinedArea = BoxArea(BoxUnion(nodes[index].box, leafBox));
+
+        // Cost of a new parent here, and the growth pushed onto the ancestors
+        float cost = 2.0f*combinedArea;
+        float inheritanceCost = 2.0f*(combinedArea - area);
+
+        float cost1 = BoxArea(BoxUnion(leafBox, nodes[child1].box)) + inheritanceCost;
+        if (!nodes[child1].IsLeaf()) cost1 -= BoxArea(nodes[child1].box);
+        float cost2 = BoxArea(BoxUnion(leafBox, nodes[child2].box)) + inheritanceCost;
+        if (!nodes[child2].IsLeaf()) cost2 -= BoxArea(nodes[child2].box);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = (cost1 < cost2) ? child1 : child2;
+    }
+    int sibling = index;
+
+    // New parent for the sibling and the leaf
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = BoxUnion(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != INVALID_PROXY) {
+        if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else nodes[oldParent].child2 = newParent;
+    } else {
+        root = newParent;
+    }
+
+    RefitAncestors(nodes[leaf].parent);
+}
+
+void DynamicBVH::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = INVALID_PROXY;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+    // The sibling takes the parent's place
+    if (grandParent != INVALID_PROXY) {
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+        RefitAncestors(grandParent);
+    } else {
+        root = sibling;
+        nodes[sibling].parent = INVALID_PROXY;
+        FreeNode(parent);
+    }
+}
+
+void DynamicBVH::RefitAncestors(int node) {
+    while (node != INVALID_PROXY) {
+        node = Balance(node);
+
+        int child1 = nodes[node].child1;
+        int child2 = nodes[node].child2;
+        nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[node].box = BoxUnion(nodes[child1].box, nodes[child2].box);
+
+        node = nodes[node].parent;
+    }
+}
+
+// Rotate the taller grandchild up when the children's heights differ by
+// more than one, returns the node now at this position
+int DynamicBVH::Balance(int iA) {
+    Node& A = nodes[iA];
+    if (A.IsLeaf() || A.height < 2) return iA;
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+    int balance = C.height - B.height;
+
+    // Rotate C up
+    if (balance > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        if (C.parent != INVALID_PROXY) {
+            if (nodes[C.parent].child1 == iA) nodes[C.parent].child1 = iC;
+            else nodes[C.parent].child2 = iC;
+        } else {
+            root = iC;
+        }
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = BoxUnion(B.box, G.box);
+            C.box = BoxUnion(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = BoxUnion(B.box, F.box);
+            C.box = BoxUnion(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // Rotate B up
+    if (balance < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        if (B.parent != INVALID_PROXY) {
+            if (nodes[B.parent].child1 == iA) nodes[B.parent].child1 = iB;
+            else nodes[B.parent].child2 = iB;
+        } else {
+            root = iB;
+        }
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = BoxUnion(C.box, E.box);
+            B.box = BoxUnion(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = BoxUnion(C.box, D.box);
+            B.box = BoxUnion(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+int DynamicBVH::Raycast(const Ray& ray, float maxDistance, float* hitDistance) const {
+    int hitUserData = -1;
+    float closest = maxDistance;
+    if (root == INVALID_PROXY) return hitUserData;
+
+    NodeStack stack;
+    stack.Push(root);
+    while (!stack.IsEmpty()) {
+        int index = stack.Pop();
+
+        // Boxes behind the closest hit so far cannot contain a nearer one
+        const Node& node = nodes[index];
+        if (RayBoxDistance(ray, node.box, closest) < 0.0f) continue;
+
+        if (node.IsLeaf()) {
+            // raylib reports spheres behind the origin as hits with a negative
+            // distance when the ray's line passes through them
+            RayCollision collision = GetRayCollisionSphere(ray, node.center, node.radius);
+            if (collision.hit && collision.distance >= 0.0f && collision.distance < closest) {
+                closest = collision.distance;
+                hitUserData = node.userData;
+            }
+        } else {
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+
+    if (hitDistance != nullptr && hitUserData >= 0) *hitDistance = closest;
+    return hitUserData;
+}
+
+void DynamicBVH::QuerySphere(const Vector3& center, float radius, std::vector<int>& results) const {
+    if (root == INVALID_PROXY) return;
+
+    NodeStack stack;
+    stack.Push(root);
+    while (!stack.IsEmpty()) {
+        int index = stack.Pop();
+
+        const Node& node = nodes[index];
+        if (!CheckCollisionBoxSphere(node.box, center, radius)) continue;
+
+        if (node.IsLeaf()) {
+            if (Vector3Distance(center, node.center) <= radius + node.radius) {
+                results.push_back(node.userData);
+            }
+        } else {
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+}
+
+void DynamicBVH::QueryClosePairs(float distance, std::vector<std::pair<int, int>>& pairs) const {
+    if (root == INVALID_PROXY) return;
+
+    NodeStack stack;
+    for (int leaf = 0; leaf < (int)nodes.size(); leaf++) {
+        if (nodes[leaf].height != 0) continue;
+        const Node& query = nodes[leaf];
+        float queryRadius = query.radius + distance;
+
+        stack.Clear();
+        stack.Push(root);
+        while (!stack.IsEmpty()) {
+            int index = stack.Pop();
+
+            const Node& node = nodes[index];
+            if (!CheckCollisionBoxSphere(node.box, query.center, queryRadius)) continue;
+
+            if (node.IsLeaf()) {
+                // Each pair once, from its lower node index
+                float gap = Vector3Distance(query.center, node.center) - query.radius - node.radius;
+                if (index > leaf && gap < distance) {
+                    pairs.push_back(std::make_pair(query.userData, node.userData));
+                }
+            } else {
+                stack.Push(node.child1);
+                stack.Push(node.child2);
+            }
+        }
+    }
+}
+
+void DynamicBVH::SetMargin(float newMargin) {
+    margin = newMargin;
+}
+
+float DynamicBVH::GetMargin() const {
+    return margin;
+}
+
+int DynamicBVH::GetProxyCount() const {
+    return proxyCount;
+}
+
+int DynamicBVH::GetNodeCount() const {
+    return (proxyCount > 0) ? 2*proxyCount - 1 : 0;
+}
+
+int DynamicBVH::GetHeight() const {
+    return (root == INVALID_PROXY) ? 0 : nodes[root].height;
+}
+
+int DynamicBVH::GetReinsertCount() const {
+    return reinsertCount;
+}
+
+void DynamicBVH::ResetReinsertCount() {
+    reinsertCount = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef DYNAMIC_BVH_H
+#define DYNAMIC_BVH_H
+
+#include "raylib.h"
+#include <utility>
+#include <vector>
+
+#define INVALID_PROXY -1
+
+// Dynamic bounding volume hierarchy over bounding spheres. Leaves store a
+// fat box around their sphere, so a body that moves a little needs no
+// update; once it leaves the fat box it is removed and reinserted. Tree
+// rotations on the way up keep the hierarchy balanced.
+class DynamicBVH {
+public:
+    // Constructor/Destructor
+    DynamicBVH();
+    ~DynamicBVH() = default;
+
+    // Proxies for bounding spheres, userData is returned by the queries
+    int CreateProxy(const Vector3& center, float radius, int userData);
+    void DestroyProxy(int proxy);
+
+    // Update a proxy's sphere, returns true if it had to be reinserted
+    bool MoveProxy(int proxy, const Vector3& center, float radius);
+    int GetUserData(int proxy) const;
+
+    // Nearest sphere hit by the ray, returns its userData or -1
+    int Raycast(const Ray& ray, float maxDistance, float* hitDistance) const;
+
+    // userData of every sphere that intersects the query sphere
+    void QuerySphere(const Vector3& center, float radius, std::vector<int>& results) const;
+
+    // userData pairs of spheres whose surfaces are closer than distance
+    void QueryClosePairs(float distance, std::vector<std::pair<int, int>>& pairs) const;
+
+    // Fat box margin added around every sphere
+    void SetMargin(float margin);
+    float GetMargin() const;
+
+    // Statistics
+    int GetProxyCount() const;
+    int GetNodeCount() const;
+    int GetHeight() const;
+    int GetReinsertCount() const;
+    void ResetReinsertCount();
+
+private:
+    struct Node {
+        BoundingBox box;        // Fat box for leaves
+        Vector3 center;         // Leaf sphere
+        float radius;
+        int parent;             // Next free node while unused
+        int child1;
+        int child2;
+        int height;             // 0 for leaves, -1 when free
+        int userData;
+
+        bool IsLeaf() const { return child1 == INVALID_PROXY; }
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    int proxyCount;
+    int reinsertCount;
+    float margin;
+
+    // Helper methods
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node);
+    void RefitAncestors(int node);
+    BoundingBox FatBox(const Vector3& center, float radius) const;
+};
+
+#endif // DYNAMIC_BVH_H
@@ -0,0 +1,89 @@
+#include "FrameArena.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+FrameArena::FrameArena(size_t capacity)
+    : block(new unsigned char[capacity]),
+      capacity(capacity),
+      offset(0),
+      overflowBytes(0),
+      lastFrameBytes(0),
+      lastOverflowBytes(0),
+      peakBytes(0)
+{
+}
+
+FrameArena::~FrameArena() {
+    for (void* memory : overflowBlocks) {
+        free(memory);
+    }
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    uintptr_t base = (uintptr_t)block.get();
+
+    // Claim [aligned, aligned + size) unless another thread moved the offset first
+    size_t current = offset.load(std::memory_order_relaxed);
+    while (true) {
+        size_t aligned = ((base + current + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if (aligned + size > capacity) break;
+        if (offset.compare_exchange_weak(current, aligned + size, std::memory_order_relaxed)) {
+            return block.get() + aligned;
+        }
+    }
+
+    // Out of space for this frame, borrow from the heap
+    size_t padded = size + alignment;
+    void* memory = malloc(padded);
+    if (memory == nullptr) return nullptr;
+
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflowBlocks.push_back(memory);
+    overflowBytes += padded;
+    return (void*)(((uintptr_t)memory + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void FrameArena::Reset() {
+    size_t used = offset.load(std::memory_order_relaxed);
+    lastFrameBytes = used + overflowBytes;
+    lastOverflowBytes = overflowBytes;
+    peakBytes = std::max(peakBytes, lastFrameBytes);
+
+    for (void* memory : overflowBlocks) {
+        free(memory);
+    }
+    overflowBlocks.clear();
+
+    // Grow once so the next frame of the same size stays in the block
+    if (overflowBytes > 0) {
+        size_t grown = std::max(capacity*2, lastFrameBytes + lastFrameBytes/2);
+        TraceLog(LOG_INFO, "ARENA: Frame needed %zu bytes, growing from %zu to %zu", lastFrameBytes, capacity, grown);
+        block.reset(new unsigned char[grown]);
+        capacity = grown;
+    }
+
+    overflowBytes = 0;
+    offset.store(0, std::memory_order_relaxed);
+}
+
+size_t FrameArena::GetCapacity() const {
+    return capacity;
+}
+
+size_t FrameArena::GetUsedBytes() const {
+    return offset.load(std::memory_order_relaxed);
+}
+
+size_t FrameArena::GetLastFrameBytes() const {
+    return lastFrameBytes;
+}
+
+size_t FrameArena::GetPeakBytes() const {
+    return peakBytes;
+}
+
+size_t FrameArena::GetLastOverflowBytes() const {
+    return lastOverflowBytes;
+}
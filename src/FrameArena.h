@@ -0,0 +1,59 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that only lives until the end of the frame.
+// Allocating bumps an offset (safe from job system workers), Reset() after
+// EndDrawing releases everything at once. Requests that do not fit go to
+// the heap, and the next Reset() grows the arena so the frame fits again.
+class FrameArena {
+public:
+    // Constructor/Destructor
+    explicit FrameArena(size_t capacity);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Raw memory, valid until the next Reset
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for count objects, destructors never run
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "Frame arena objects are never destroyed");
+        return static_cast<T*>(Allocate(count*sizeof(T), alignof(T)));
+    }
+
+    // End of frame, no allocation may be in use or in flight
+    void Reset();
+
+    // Statistics
+    size_t GetCapacity() const;
+    size_t GetUsedBytes() const;            // Current frame so far
+    size_t GetLastFrameBytes() const;       // Including overflow
+    size_t GetPeakBytes() const;
+    size_t GetLastOverflowBytes() const;
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity;
+    std::atomic<size_t> offset;
+
+    // Heap fallback for the current frame
+    std::mutex overflowMutex;
+    std::vector<void*> overflowBlocks;
+    size_t overflowBytes;
+
+    size_t lastFrameBytes;
+    size_t lastOverflowBytes;
+    size_t peakBytes;
+};
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,189 @@
+// Headless check that the per-frame CPU work does not touch the heap once
+// warmed up. Runs the frame graph, light binning, BVH refit and queries and
+// the frame arena on synthetic bodies, without a window or GPU. Built with
+// TRACK_ALLOCATIONS; exits with 1 if a steady-state frame allocated.
+// Usage: FrameBench [frames] [bodies] [lights] [thread count]
+#include "JobSystem.h"
+#include "ClusteredLights.h"
+#include "DynamicBVH.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "Tools.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Body on a circular orbit around its parent, the sun has no parent
+struct BenchBody {
+    int parent;
+    float orbitDistance;
+    float orbitSpeed;           // Radians per second
+    float orbitAngle;
+    float radius;
+    Vector3 position;
+    Matrix model;
+    bool visible;
+};
+
+static void UpdateBody(std::vector<BenchBody>& bodies, int index, float deltaTime) {
+    BenchBody& body = bodies[index];
+    if (body.parent < 0) return;
+
+    body.orbitAngle += body.orbitSpeed*deltaTime;
+    Vector3 center = bodies[body.parent].position;
+    body.position = Vector3{ center.x + body.orbitDistance*cosf(body.orbitAngle), center.y,
+                             center.z + body.orbitDistance*sinf(body.orbitAngle) };
+}
+
+int main(int argc, char** argv)
+{
+    int frameCount = (argc > 1) ? atoi(argv[1]) : 600;
+    int bodyCount = (argc > 2) ? atoi(argv[2]) : 1000;
+    int lightCount = (argc > 3) ? atoi(argv[3]) : 128;
+    int threadCount = (argc > 4) ? atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+    const int warmupFrames = 120;
+    if (frameCount <= warmupFrames) frameCount = warmupFrames + 60;
+    if (bodyCount < 2) bodyCount = 2;
+    if (lightCount < 0) lightCount = 0;
+    if (lightCount > MAX_CLUSTERED_LIGHTS) lightCount = MAX_CLUSTERED_LIGHTS;
+    if (threadCount <= 0) threadCount = 4;
+    const int planetCount = (bodyCount - 1 < 8) ? bodyCount - 1 : 8;
+    const float deltaTime = 1.0f/60.0f;
+
+    if (!IsAllocationHookEnabled()) {
+        fprintf(stderr, "FrameBench needs TRACK_ALLOCATIONS to count operator new\n");
+        return 2;
+    }
+
+    // Sun, planets around it and moons around the planets
+    SetRandomSeed(7);
+    std::vector<BenchBody> bodies(bodyCount);
+    for (int i = 0; i < bodyCount; i++) {
+        BenchBody& body = bodies[i];
+        bool planet = (i >= 1 && i <= planetCount);
+        body.parent = (i == 0) ? -1 : (planet ? 0 : 1 + i % planetCount);
+        body.orbitDistance = planet ? 4.0f*i : 0.5f + GetRandomValue(0, 100)*0.01f;
+        body.orbitSpeed = GetRandomValue(5, 50)*0.01f;
+        body.orbitAngle = GetRandomValue(0, 359)*DEG2RAD;
+        body.radius = (i == 0) ? 2.0f : (planet ? 0.5f : 0.05f);
+        body.position = Vector3Zero();
+        body.model = MatrixIdentity();
+        body.visible = true;
+    }
+    for (int i = 0; i < bodyCount; i++) UpdateBody(bodies, i, 0.0f);
+
+    std::vector<PointLight> lights(MAX_CLUSTERED_LIGHTS);
+    std::vector<Vector4> lightOrbits(MAX_CLUSTERED_LIGHTS);
+    for (int i = 0; i < MAX_CLUSTERED_LIGHTS; i++) {
+        lightOrbits[i] = Vector4{ 1.02f + GetRandomValue(0, 100)*0.004f, GetRandomValue(-90, 90)*DEG2RAD,
+                                  GetRandomValue(0, 359)*DEG2RAD, GetRandomValue(5, 30)*0.01f };
+        lights[i].color = Vector3{ 1.0f, 0.8f, 0.6f };
+        lights[i].range = 0.3f;
+        lights[i].intensity = 1.0f;
+    }
+
+    JobSystem jobSystem;
+    jobSystem.Start(threadCount - 1);
+    ClusteredLights clusteredLights;
+    DynamicBVH bodyTree;
+    std::vector<int> bodyProxies(bodyCount);
+    for (int i = 0; i < bodyCount; i++) {
+        bodyProxies[i] = bodyTree.CreateProxy(bodies[i].position, bodies[i].radius, i);
+    }
+    std::vector<int> queryResults;
+    std::vector<std::pair<int, int>> closeApproaches;
+
+    // Same shape as the app's frame graph: updates in orbit order, then
+    // draw preparation and light binning in parallel
+    Camera3D camera = { { 0.0f, 20.0f, 40.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 45.0f, CAMERA_PERSPECTIVE };
+    const float aspect = 16.0f/9.0f;
+    Matrix viewProjection = MatrixIdentity();
+    float simulationTime = 0.0f;
+
+    TaskGraph frameGraph;
+    TaskGraph::TaskId planetTask = frameGraph.Add("Update planets", [&]() {
+        for (int i = 1; i <= planetCount; i++) UpdateBody(bodies, i, deltaTime);
+    });
+    TaskGraph::TaskId moonTask = frameGraph.Add("Update moons", [&]() {
+        jobSystem.ParallelFor(planetCount + 1, bodyCount, 64, [&](int first, int last) {
+            for (int i = first; i < last; i++) UpdateBody(bodies, i, deltaTime);
+        });
+    });
+    frameGraph.Depend(moonTask, planetTask);
+    TaskGraph::TaskId prepareTask = frameGraph.Add("Prepare draws", [&]() {
+        jobSystem.ParallelFor(0, bodyCount, 64, [&](int first, int last) {
+            for (int i = first; i < last; i++) {
+                BenchBody& body = bodies[i];
+                body.model = MatrixMultiply(MatrixScale(body.radius, body.radius, body.radius),
+                                            MatrixTranslate(body.position.x, body.position.y, body.position.z));
+                body.visible = IsSphereInFrustum(viewProjection, body.position, body.radius);
+            }
+        });
+    });
+    frameGraph.Depend(prepareTask, moonTask);
+    TaskGraph::TaskId lightTask = frameGraph.Add("Cluster lights", [&]() {
+        Vector3 center = bodies[1].position;
+        for (int i = 0; i < lightCount; i++) {
+            const Vector4& orbit = lightOrbits[i];
+            float angle = orbit.z + orbit.w*simulationTime;
+            Vector3 offset = { cosf(angle), sinf(angle)*sinf(orbit.y), sinf(angle)*cosf(orbit.y) };
+            lights[i].position = Vector3Add(center, Vector3Scale(offset, orbit.x*bodies[1].radius));
+        }
+        clusteredLights.SetLights(lights.data(), lightCount);
+        clusteredLights.Build(camera, aspect, jobSystem);
+    });
+    frameGraph.Depend(lightTask, planetTask);
+
+    FrameArena frameArena(256*1024);
+    FrameAllocationTracker frameAllocations(warmupFrames);
+    printf("Running %i frames (%i warm-up) with %i bodies, %i lights, %i threads\n",
+           frameCount, warmupFrames, bodyCount, lightCount, threadCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frameCount; frame++) {
+        // Orbit the camera so binning and culling see a changing view
+        float cameraAngle = frame*0.01f;
+        camera.position = Vector3{ 40.0f*sinf(cameraAngle), 20.0f, 40.0f*cosf(cameraAngle) };
+        Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+        Matrix projection = MatrixPerspective(camera.fovy*DEG2RAD, aspect, SCENE_NEAR_PLANE, SCENE_FAR_PLANE);
+        viewProjection = MatrixMultiply(view, projection);
+
+        jobSystem.ResetStatistics();
+        frameGraph.Run(jobSystem);
+        simulationTime += deltaTime;
+
+        bodyTree.ResetReinsertCount();
+        for (int i = 0; i < bodyCount; i++) {
+            bodyTree.MoveProxy(bodyProxies[i], bodies[i].position, bodies[i].radius);
+        }
+        queryResults.clear();
+        bodyTree.QuerySphere(bodies[1].position, 5.0f, queryResults);
+        closeApproaches.clear();
+        bodyTree.QueryClosePairs(0.1f, closeApproaches);
+
+        // Draw list as the app builds it
+        const BenchBody** drawList = frameArena.AllocateArray<const BenchBody*>(bodyCount);
+        int drawCount = 0;
+        for (int i = 0; i < bodyCount; i++) {
+            if (bodies[i].visible) drawList[drawCount++] = &bodies[i];
+        }
+
+        frameArena.Reset();
+        frameAllocations.EndFrame();
+    }
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%.3f ms per frame, arena peak %zu bytes, light build %.3f ms\n",
+           milliseconds/frameCount, frameArena.GetPeakBytes(), clusteredLights.GetBuildMilliseconds());
+    if (frameAllocations.GetViolationCount() > 0) {
+        printf("FAIL: %i of %i steady-state frames allocated, last at frame %llu\n",
+               frameAllocations.GetViolationCount(), frameCount - warmupFrames,
+               (unsigned long long)frameAllocations.GetLastViolationFrame());
+        return 1;
+    }
+    printf("OK: no heap allocations in %i steady-state frames\n", frameCount - warmupFrames);
+    return 0;
+}
@@ -0,0 +1,39 @@
+// Headless job system scaling test, usable without a window or GPU.
+// Usage: JobScaling [max threads] [body count]
+#include "JobSystem.h"
+#include "Tools.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    int maxThreads = (argc > 1) ? atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    int itemCount = (argc > 2) ? atoi(argv[2]) : 20000;
+    if (maxThreads <= 0) maxThreads = 4;
+    if (itemCount <= 0) itemCount = 20000;
+
+    // Fixed view over the synthetic bodies, the window aspect is not available
+    Camera3D camera = { { 0.0f, 10.0f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 45.0f, CAMERA_PERSPECTIVE };
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection = MatrixPerspective(camera.fovy*DEG2RAD, 16.0f/9.0f, SCENE_NEAR_PLANE, SCENE_FAR_PLANE);
+    Matrix viewProjection = MatrixMultiply(view, projection);
+
+    printf("Preparing %i bodies with 1 to %i threads\n", itemCount, maxThreads);
+
+    std::vector<Matrix> models(itemCount);
+    std::vector<unsigned char> visible(itemCount);
+    std::vector<JobScalingResult> results = MeasureJobScaling(maxThreads, itemCount, 256, [&](int first, int last) {
+        for (int i = first; i < last; i++) {
+            visible[i] = PrepareTestBody(i, viewProjection, models[i]);
+        }
+    });
+
+    printf("%8s %12s %10s %12s\n", "Threads", "Time (ms)", "Speedup", "Efficiency");
+    for (const JobScalingResult& result : results) {
+        printf("%8i %12.3f %9.2fx %11.0f%%\n", result.threadCount, result.milliseconds, result.speedup,
+               100.0*result.speedup/result.threadCount);
+    }
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+
+// Queue owned by the current thread, only valid for the system it belongs to
+static thread_local const JobSystem* threadJobSystem = nullptr;
+static thread_local int threadQueueIndex = 0;
+
+JobSystem::JobSystem()
+    : running(false),
+      queuedJobs(0),
+      executedJobs(0),
+      stolenJobs(0)
+{
+    queues.emplace_back(new WorkerQueue());
+}
+
+JobSystem::~JobSystem() {
+    Stop();
+}
+
+void JobSystem::Start(int workerCount) {
+    Stop();
+
+    queues.clear();
+    for (int i = 0; i <= workerCount; i++) {
+        queues.emplace_back(new WorkerQueue());
+    }
+
+    running = true;
+    for (int i = 1; i <= workerCount; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+void JobSystem::Stop() {
+    if (!running) return;
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void JobSystem::WorkerQueue::PushBack(QueuedJob&& job) {
+    if (count == jobs.size()) {
+        std::vector<QueuedJob> grown(jobs.size()*2);
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = std::move(jobs[(head + i) % jobs.size()]);
+        }
+        jobs.swap(grown);
+        head = 0;
+    }
+    jobs[(head + count) % jobs.size()] = std::move(job);
+    count++;
+}
+
+bool JobSystem::WorkerQueue::PopBack(QueuedJob& job) {
+    if (count == 0) return false;
+    count--;
+    job = std::move(jobs[(head + count) % jobs.size()]);
+    return true;
+}
+
+bool JobSystem::WorkerQueue::PopFront(QueuedJob& job) {
+    if (count == 0) return false;
+    job = std::move(jobs[head]);
+    head = (head + 1) % jobs.size();
+    count--;
+    return true;
+}
+
+int JobSystem::GetQueueIndex() const {
+    return (threadJobSystem == this) ? threadQueueIndex : 0;
+}
+
+void JobSystem::Submit(Job job, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    WorkerQueue& queue = *queues[GetQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.PushBack(QueuedJob{ std::move(job), &counter });
+    }
+    queuedJobs.fetch_add(1);
+
+    // Taking the sleep lock orders this with a worker about to wait
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool JobSystem::TryRunJob(int queueIndex) {
+    QueuedJob queued;
+    bool found = false;
+
+    // Newest job from our own queue, it is most likely still in cache
+    {
+        WorkerQueue& queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        found = queue.PopBack(queued);
+    }
+
+    // Otherwise steal the oldest job of another queue
+    int queueCount = (int)queues.size();
+    for (int i = 1; i < queueCount && !found; i++) {
+        WorkerQueue& victim = *queues[(queueIndex + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.PopFront(queued)) {
+            found = true;
+            stolenJobs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!found) return false;
+
+    queuedJobs.fetch_sub(1);
+    queued.job();
+    executedJobs.fetch_add(1, std::memory_order_relaxed);
+    queued.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    int queueIndex = GetQueueIndex();
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        if (!TryRunJob(queueIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerLoop(int queueIndex) {
+    threadJobSystem = this;
+    threadQueueIndex = queueIndex;
+
+    while (running) {
+        if (TryRunJob(queueIndex)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return queuedJobs.load() > 0 || !running; });
+    }
+}
+
+void JobSystem::ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& function) {
+    if (end <= begin) return;
+    grainSize = std::max(1, grainSize);
+
+    // Queue every range but the first, which runs right here
+    JobCounter counter;
+    for (int first = begin + grainSize; first < end; first += grainSize) {
+        int last = std::min(first + grainSize, end);
+        Submit([&function, first, last]() { function(first, last); }, counter);
+    }
+    function(begin, std::min(begin + grainSize, end));
+    Wait(counter);
+}
+
+int JobSystem::GetThreadCount() const {
+    return (int)workers.size() + 1;
+}
+
+void JobSystem::ResetStatistics() {
+    executedJobs = 0;
+    stolenJobs = 0;
+}
+
+int JobSystem::GetExecutedJobs() const {
+    return executedJobs;
+}
+
+int JobSystem::GetStolenJobs() const {
+    return stolenJobs;
+}
+
+TaskGraph::TaskGraph()
+    : runJobSystem(nullptr),
+      runCounter(nullptr)
+{
+}
+
+TaskGraph::TaskId TaskGraph::Add(const char* name, std::function<void()> work) {
+    Task task;
+    task.name = name;
+    task.work = std::move(work);
+    task.dependencyCount = 0;
+    task.remaining.reset(new std::atomic<int>(0));
+    tasks.push_back(std::move(task));
+    return (TaskId)tasks.size() - 1;
+}
+
+void TaskGraph::Depend(TaskId task, TaskId dependency) {
+    int taskCount = (int)tasks.size();
+    if (task < 0 || task >= taskCount || dependency < 0 || dependency >= taskCount || task == dependency) return;
+
+    tasks[dependency].successors.push_back(task);
+    tasks[task].dependencyCount++;
+}
+
+void TaskGraph::Schedule(TaskId task) {
+    runJobSystem->Submit([this, task]() {
+        tasks[task].work();
+
+        // The last finished dependency releases a successor
+        for (TaskId successor : tasks[task].successors) {
+            if (tasks[successor].remaining->fetch_sub(1) == 1) {
+                Schedule(successor);
+            }
+        }
+    }, *runCounter);
+}
+
+void TaskGraph::Run(JobSystem& jobSystem) {
+    for (Task& task : tasks) {
+        task.remaining->store(task.dependencyCount);
+    }
+
+    // Successors are queued before their dependency's job completes, so the
+    // counter only reaches zero once the whole graph has run
+    JobCounter counter;
+    runJobSystem = &jobSystem;
+    runCounter = &counter;
+    for (TaskId task = 0; task < (TaskId)tasks.size(); task++) {
+        if (tasks[task].dependencyCount == 0) {
+            Schedule(task);
+        }
+    }
+    jobSystem.Wait(counter);
+    runJobSystem = nullptr;
+    runCounter = nullptr;
+}
+
+void TaskGraph::Clear() {
+    tasks.clear();
+}
+
+int TaskGraph::GetTaskCount() const {
+    return (int)tasks.size();
+}
+
+const char* TaskGraph::GetTaskName(TaskId task) const {
+    return tasks[task].name;
+}
+
+std::vector<JobScalingResult> MeasureJobScaling(int maxThreads, int itemCount, int grainSize,
+                                                const std::function<void(int, int)>& function) {
+    std::vector<JobScalingResult> results;
+    const int runs = 5;
+
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount++) {
+        JobSystem jobSystem;
+        jobSystem.Start(threadCount - 1);
+
+        // Warm up, then keep the best run to filter out scheduling noise
+        jobSystem.ParallelFor(0, itemCount, grainSize, function);
+        double best = 0.0;
+        for (int run = 0; run < runs; run++) {
+            auto start = std::chrono::steady_clock::now();
+            jobSystem.ParallelFor(0, itemCount, grainSize, function);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0 || milliseconds < best) best = milliseconds;
+        }
+
+        double speedup = results.empty() ? 1.0 : results[0].milliseconds/std::max(best, 1e-6);
+        results.push_back(JobScalingResult{ threadCount, best, speedup });
+    }
+    return results;
+}
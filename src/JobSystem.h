@@ -0,0 +1,146 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts outstanding jobs, Wait() returns once it drops to zero
+struct JobCounter {
+    std::atomic<int> pending;
+    JobCounter() : pending(0) {}
+};
+
+// Work-stealing scheduler. Every worker owns a deque: it pushes and pops
+// its own jobs at the back and steals from the front of other deques when
+// it runs dry. The thread that calls Wait() runs jobs too, so nested
+// parallel work inside a job does not deadlock.
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+
+    // Constructor/Destructor
+    JobSystem();
+    ~JobSystem();
+
+    // Start workerCount background threads (0 runs everything on the caller)
+    void Start(int workerCount);
+    void Stop();
+
+    // Queue a job, counter is incremented now and decremented when it ran
+    void Submit(Job job, JobCounter& counter);
+
+    // Run queued jobs on the calling thread until the counter reaches zero
+    void Wait(JobCounter& counter);
+
+    // Split [begin, end) into ranges of about grainSize items and run
+    // function(first, last) on them in parallel, returns when all are done
+    void ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& function);
+
+    // Worker threads plus the calling thread
+    int GetThreadCount() const;
+
+    // Statistics since the last reset
+    void ResetStatistics();
+    int GetExecutedJobs() const;
+    int GetStolenJobs() const;
+
+private:
+    struct QueuedJob {
+        Job job;
+        JobCounter* counter;
+    };
+
+    // Double-ended ring of jobs, it only allocates when it has to grow
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<QueuedJob> jobs;
+        size_t head;            // Oldest job
+        size_t count;
+
+        WorkerQueue() : jobs(64), head(0), count(0) {}
+        void PushBack(QueuedJob&& job);
+        bool PopBack(QueuedJob& job);
+        bool PopFront(QueuedJob& job);
+    };
+
+    // Queue 0 belongs to threads outside the pool, 1..n to the workers
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+
+    // Idle workers sleep until something is queued
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queuedJobs;
+
+    // Statistics
+    std::atomic<int> executedJobs;
+    std::atomic<int> stolenJobs;
+
+    // Helper methods
+    int GetQueueIndex() const;
+    bool TryRunJob(int queueIndex);
+    void WorkerLoop(int queueIndex);
+};
+
+// Frame graph: tasks with dependencies, rebuilt or rerun every frame.
+// A task is queued as soon as all tasks it depends on have finished.
+class TaskGraph {
+public:
+    typedef int TaskId;
+
+    // Constructor/Destructor
+    TaskGraph();
+    ~TaskGraph() = default;
+
+    // Add a task, returns its id
+    TaskId Add(const char* name, std::function<void()> work);
+
+    // Task will not start before dependency has finished
+    void Depend(TaskId task, TaskId dependency);
+
+    // Run every task on the job system and wait for all of them
+    void Run(JobSystem& jobSystem);
+
+    void Clear();
+    int GetTaskCount() const;
+    const char* GetTaskName(TaskId task) const;
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> work;
+        std::vector<TaskId> successors;
+        int dependencyCount;
+        std::unique_ptr<std::atomic<int>> remaining;
+    };
+
+    std::vector<Task> tasks;
+
+    // Set for the duration of Run, so queued tasks only capture their id
+    // and fit in std::function's inline storage
+    JobSystem* runJobSystem;
+    JobCounter* runCounter;
+
+    // Helper methods
+    void Schedule(TaskId task);
+};
+
+// Result of timing a parallel loop with a given number of threads
+struct JobScalingResult {
+    int threadCount;
+    double milliseconds;
+    double speedup;     // Relative to one thread
+};
+
+// Time a ParallelFor over itemCount items with 1..maxThreads threads, each
+// measured as the best of a few runs on a dedicated job system
+std::vector<JobScalingResult> MeasureJobScaling(int maxThreads, int itemCount, int grainSize,
+                                                const std::function<void(int, int)>& function);
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,307 @@
+#include "OrbitTrails.h"
+#include "Tools.h"
+#include "external/glad.h"
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+OrbitTrails::OrbitTrails()
+    : pointsPerTrail(0),
+      maxTrails(0),
+      maxAngle(2.0f),
+      minSpacing(0.01f),
+      maxSpacing(1.0f),
+      fadeTime(20.0f),
+      color(SKYBLUE),
+      uploadBytes(0),
+      drawCalls(0),
+      vao(0),
+      vbo(0),
+      region(0),
+      mvpLoc(-1),
+      currentTimeLoc(-1),
+      fadeTimeLoc(-1),
+      trailColorLoc(-1)
+{
+    shader = { 0 };
+    for (void*& fence : regionFences) {
+        fence = nullptr;
+    }
+}
+
+OrbitTrails::~OrbitTrails() {
+    Unload();
+}
+
+void OrbitTrails::Load(int trailCapacity, int points) {
+    maxTrails = trailCapacity;
+    pointsPerTrail = points;
+
+    // Every ring has one extra vertex mirroring its first point, so a
+    // wrapped ring is drawn as two strips that still connect
+    vertices.assign((size_t)maxTrails*(pointsPerTrail + 1), TrailVertex{ 0.0f, 0.0f, 0.0f, 0.0f });
+    trails.reserve(maxTrails);
+    drawFirsts.reserve(maxTrails*2);
+    drawCounts.reserve(maxTrails*2);
+
+    // Vertex buffer with position and emission time, one region per frame
+    // in flight so uploads never overwrite vertices the GPU is reading
+    vao = rlLoadVertexArray();
+    rlEnableVertexArray(vao);
+    vbo = rlLoadVertexBuffer(nullptr, (int)(ORBIT_TRAIL_REGIONS*vertices.size()*sizeof(TrailVertex)), true);
+    rlSetVertexAttribute(0, 4, RL_FLOAT, false, sizeof(TrailVertex), 0);
+    rlEnableVertexAttribute(0);
+    rlDisableVertexArray();
+
+    shader = LoadShader("resources/shaders/trail.vs", "resources/shaders/trail.fs");
+    mvpLoc = GetShaderLocation(shader, "mvp");
+    currentTimeLoc = GetShaderLocation(shader, "currentTime");
+    fadeTimeLoc = GetShaderLocation(shader, "fadeTime");
+    trailColorLoc = GetShaderLocation(shader, "trailColor");
+}
+
+void OrbitTrails::Unload() {
+    for (void*& fence : regionFences) {
+        if (fence != nullptr) glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+    region = 0;
+
+    if (vao > 0) rlUnloadVertexArray(vao);
+    if (vbo > 0) rlUnloadVertexBuffer(vbo);
+    if (shader.id > 0) UnloadShader(shader);
+    vao = 0;
+    vbo = 0;
+    shader = { 0 };
+
+    trails.clear();
+    vertices.clear();
+}
+
+int OrbitTrails::AddTrail() {
+    if ((int)trails.size() >= maxTrails) return -1;
+
+    Trail state = { -1, 0, Vector3Zero(), Vector3Zero() };
+    for (int copy = 0; copy < ORBIT_TRAIL_REGIONS; copy++) {
+        state.dirtyMin[copy] = INT_MAX;
+        state.dirtyMax[copy] = -1;
+    }
+    trails.push_back(state);
+    return (int)trails.size() - 1;
+}
+
+void OrbitTrails::ClearTrail(int trail) {
+    if (trail < 0 || trail >= (int)trails.size()) return;
+    trails[trail].head = -1;
+    trails[trail].count = 0;
+}
+
+int OrbitTrails::TrailBase(int trail) const {
+    return trail*(pointsPerTrail + 1);
+}
+
+void OrbitTrails::Sample(int trail, const Vector3& position, float time) {
+    if (trail < 0 || trail >= (int)trails.size()) return;
+    Trail& state = trails[trail];
+
+    if (state.count == 0) {
+        Emit(trail, position, time);
+        return;
+    }
+
+    Vector3 offset = Vector3Subtract(position, state.lastPoint);
+    float distance = Vector3Length(offset);
+    if (distance < minSpacing) return;
+
+    // Second point only fixes the direction
+    if (state.count == 1) {
+        Emit(trail, position, time);
+        return;
+    }
+
+    // Curvature test: angle between the last segment and the chord to here
+    Vector3 direction = Vector3Scale(offset, 1.0f/distance);
+    float cosAngle = Vector3DotProduct(direction, state.lastDirection);
+    if (cosAngle < cosf(maxAngle*DEG2RAD) || distance > maxSpacing) {
+        Emit(trail, position, time);
+    }
+}
+
+void OrbitTrails::Emit(int trail, const Vector3& position, float time) {
+    Trail& state = trails[trail];
+    int base = TrailBase(trail);
+
+    if (state.count > 0) {
+        state.lastDirection = Vector3Normalize(Vector3Subtract(position, state.lastPoint));
+    }
+
+    state.head = (state.head + 1) % pointsPerTrail;
+    state.count = (state.count < pointsPerTrail) ? state.count + 1 : pointsPerTrail;
+    state.lastPoint = position;
+
+    TrailVertex vertex = { position.x, position.y, position.z, time };
+    vertices[base + state.head] = vertex;
+    MarkDirty(state, state.head);
+
+    // Keep the mirror vertex in sync with the first ring slot
+    if (state.head == 0) {
+        vertices[base + pointsPerTrail] = vertex;
+        MarkDirty(state, pointsPerTrail);
+    }
+}
+
+void OrbitTrails::MarkDirty(Trail& state, int ringVertex) {
+    // Every region has to catch up on the change once
+    for (int copy = 0; copy < ORBIT_TRAIL_REGIONS; copy++) {
+        if (ringVertex < state.dirtyMin[copy]) state.dirtyMin[copy] = ringVertex;
+        if (ringVertex > state.dirtyMax[copy]) state.dirtyMax[copy] = ringVertex;
+    }
+}
+
+void OrbitTrails::UploadRegion() {
+    // Wait until the GPU is done with the draw that last used this region,
+    // usually long finished since it was ORBIT_TRAIL_REGIONS frames ago
+    if (regionFences[region] != nullptr) {
+        glClientWaitSync((GLsync)regionFences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync((GLsync)regionFences[region]);
+        regionFences[region] = nullptr;
+    }
+
+    // Spans are kept per ring, so rings that emit in the same frame do not
+    // merge into one span stretching across the buffer
+    size_t regionBytes = vertices.size()*sizeof(TrailVertex);
+    unsigned char* mapped = nullptr;
+    for (int trail = 0; trail < (int)trails.size(); trail++) {
+        Trail& state = trails[trail];
+        if (state.dirtyMax[region] < state.dirtyMin[region]) continue;
+
+        // Map on the first dirty ring; the fence above makes skipping
+        // the driver's synchronization safe
+        if (mapped == nullptr) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)(region*regionBytes), (GLsizeiptr)regionBytes,
+                                                      GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped == nullptr) {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                return;
+            }
+        }
+
+        size_t offset = (size_t)(TrailBase(trail) + state.dirtyMin[region])*sizeof(TrailVertex);
+        size_t size = (size_t)(state.dirtyMax[region] - state.dirtyMin[region] + 1)*sizeof(TrailVertex);
+        memcpy(mapped + offset, (const unsigned char*)vertices.data() + offset, size);
+        glFlushMappedBufferRange(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)size);
+        uploadBytes += (int)size;
+
+        state.dirtyMin[region] = INT_MAX;
+        state.dirtyMax[region] = -1;
+    }
+
+    if (mapped != nullptr) {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void OrbitTrails::Draw(const Camera3D& camera, float time) {
+    uploadBytes = 0;
+    drawCalls = 0;
+    if (vao == 0) return;
+
+    // Bring this frame's region up to date with the CPU mirror
+    UploadRegion();
+
+    // Collect one strip per trail, or two when the ring has wrapped
+    int regionBase = region*(int)vertices.size();
+    drawFirsts.clear();
+    drawCounts.clear();
+    for (int trail = 0; trail < (int)trails.size(); trail++) {
+        const Trail& state = trails[trail];
+        if (state.count < 2) continue;
+
+        int base = regionBase + TrailBase(trail);
+        int oldest = (state.head - state.count + 1 + pointsPerTrail) % pointsPerTrail;
+
+        if (oldest <= state.head) {
+            drawFirsts.push_back(base + oldest);
+            drawCounts.push_back(state.count);
+        } else {
+            // Oldest part runs up to the mirror vertex, which joins slot 0
+            drawFirsts.push_back(base + oldest);
+            drawCounts.push_back(pointsPerTrail - oldest + 1);
+            drawFirsts.push_back(base);
+            drawCounts.push_back(state.head + 1);
+        }
+    }
+
+    if (!drawFirsts.empty()) {
+        DrawStrips(camera, time);
+    }
+
+    // Next frame writes the next region while this one may still be drawn
+    regionFences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % ORBIT_TRAIL_REGIONS;
+}
+
+void OrbitTrails::DrawStrips(const Camera3D& camera, float time) {
+    // Flush raylib's batch before issuing GL draws directly
+    rlDrawRenderBatchActive();
+
+    Vector4 trailColor = ColorNormalize(color);
+    SetShaderValueMatrix(shader, mvpLoc, GetViewProjectionMatrix(camera));
+    SetShaderValue(shader, currentTimeLoc, &time, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(shader, fadeTimeLoc, &fadeTime, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(shader, trailColorLoc, &trailColor, SHADER_UNIFORM_VEC4);
+
+    // Trails are transparent, test depth but do not write it
+    rlDisableDepthMask();
+    rlEnableShader(shader.id);
+    rlEnableVertexArray(vao);
+    glMultiDrawArrays(GL_LINE_STRIP, drawFirsts.data(), drawCounts.data(), (GLsizei)drawFirsts.size());
+    rlDisableVertexArray();
+    rlDisableShader();
+    rlEnableDepthMask();
+
+    drawCalls = 1;
+}
+
+void OrbitTrails::SetMaxAngle(float degrees) {
+    maxAngle = degrees;
+}
+
+float OrbitTrails::GetMaxAngle() const {
+    return maxAngle;
+}
+
+void OrbitTrails::SetSpacing(float newMinSpacing, float newMaxSpacing) {
+    minSpacing = newMinSpacing;
+    maxSpacing = newMaxSpacing;
+}
+
+void OrbitTrails::SetFadeTime(float seconds) {
+    fadeTime = seconds;
+}
+
+float OrbitTrails::GetFadeTime() const {
+    return fadeTime;
+}
+
+void OrbitTrails::SetColor(Color newColor) {
+    color = newColor;
+}
+
+int OrbitTrails::GetPointCount() const {
+    int points = 0;
+    for (const Trail& state : trails) {
+        points += state.count;
+    }
+    return points;
+}
+
+int OrbitTrails::GetUploadBytes() const {
+    return uploadBytes;
+}
+
+int OrbitTrails::GetDrawCalls() const {
+    return drawCalls;
+}
@@ -0,0 +1,104 @@
+#ifndef ORBIT_TRAILS_H
+#define ORBIT_TRAILS_H
+
+#include "raylib.h"
+#include <vector>
+
+// Copies of the trail vertices in the GPU buffer, one is written while the
+// GPU may still draw from the others
+#define ORBIT_TRAIL_REGIONS 3
+
+// Orbit trails for many bodies stored in one GPU vertex buffer. Each trail
+// owns a fixed ring of points; new points are written into a CPU mirror
+// and each ring's dirty span is copied into the next buffer region once
+// per frame. All trails are drawn as line strips with a single multi-draw
+// call.
+class OrbitTrails {
+public:
+    // Constructor/Destructor
+    OrbitTrails();
+    ~OrbitTrails();
+
+    // Allocate the shared buffer for maxTrails rings of pointsPerTrail points
+    void Load(int maxTrails, int pointsPerTrail);
+    void Unload();
+
+    // Add a trail, returns -1 when all rings are in use
+    int AddTrail();
+    void ClearTrail(int trail);
+
+    // Feed the current body position. A point is only stored when the path
+    // has bent by more than the maximum angle or the spacing got too large.
+    void Sample(int trail, const Vector3& position, float time);
+
+    // Upload new points and draw every trail
+    void Draw(const Camera3D& camera, float time);
+
+    // Trail settings
+    void SetMaxAngle(float degrees);
+    float GetMaxAngle() const;
+    void SetSpacing(float minSpacing, float maxSpacing);
+    void SetFadeTime(float seconds);
+    float GetFadeTime() const;
+    void SetColor(Color color);
+
+    // Statistics for the last frame
+    int GetPointCount() const;
+    int GetUploadBytes() const;
+    int GetDrawCalls() const;
+
+private:
+    struct TrailVertex {
+        float x, y, z;
+        float time;         // Emission time, used for fading
+    };
+
+    struct Trail {
+        int head;           // Ring index of the newest point
+        int count;
+        Vector3 lastPoint;
+        Vector3 lastDirection;
+        int dirtyMin[ORBIT_TRAIL_REGIONS];  // Ring vertices not yet copied
+        int dirtyMax[ORBIT_TRAIL_REGIONS];  // into each region, max < min if clean
+    };
+
+    std::vector<Trail> trails;
+    std::vector<TrailVertex> vertices;     // CPU mirror of the vertex buffer
+    int pointsPerTrail;
+    int maxTrails;
+
+    // Multi-draw ranges, reused every frame
+    std::vector<int> drawFirsts;
+    std::vector<int> drawCounts;
+
+    // Settings
+    float maxAngle;
+    float minSpacing;
+    float maxSpacing;
+    float fadeTime;
+    Color color;
+
+    // Statistics
+    int uploadBytes;
+    int drawCalls;
+
+    // GPU resources
+    unsigned int vao;
+    unsigned int vbo;               // ORBIT_TRAIL_REGIONS copies back to back
+    int region;                     // Region written and drawn this frame
+    void* regionFences[ORBIT_TRAIL_REGIONS];    // GLsync of the last draw from each region
+    Shader shader;
+    int mvpLoc;
+    int currentTimeLoc;
+    int fadeTimeLoc;
+    int trailColorLoc;
+
+    // Helper methods
+    int TrailBase(int trail) const;
+    void Emit(int trail, const Vector3& position, float time);
+    void MarkDirty(Trail& state, int ringVertex);
+    void UploadRegion();
+    void DrawStrips(const Camera3D& camera, float time);
+};
+
+#endif // ORBIT_TRAILS_H
@@ -0,0 +1,268 @@
+#include "SphereMesh.h"
+#include "rlgl.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Forsyth's scoring parameters
+#define VERTEX_CACHE_SIZE 32
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+// Vertex buffer ids per Mesh, UnloadMesh deletes them all. raylib sets it in
+// config.h (9 in raylib 5.5), which is not part of its public headers.
+#ifndef MAX_MESH_VERTEX_BUFFERS
+    #define MAX_MESH_VERTEX_BUFFERS 9
+#endif
+static_assert(RL_DEFAULT_SHADER_ATTRIB_LOCATION_INDICES < MAX_MESH_VERTEX_BUFFERS, "Index buffer id must fit in Mesh::vboId");
+
+static short PackSnorm(float value) {
+    value = std::min(std::max(value, -1.0f), 1.0f);
+    return (short)std::lround(value*32767.0f);
+}
+
+static unsigned short PackUnorm(float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return (unsigned short)std::lround(value*65535.0f);
+}
+
+// Project a unit vector on the octahedron and unfold it into [-1, 1]^2
+static void PackOctahedral(Vector3 v, short* out) {
+    float invL1 = 1.0f/(fabsf(v.x) + fabsf(v.y) + fabsf(v.z));
+    float x = v.x*invL1;
+    float y = v.y*invL1;
+    if (v.z < 0.0f) {
+        float foldedX = (1.0f - fabsf(y))*((x >= 0.0f) ? 1.0f : -1.0f);
+        float foldedY = (1.0f - fabsf(x))*((y >= 0.0f) ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = PackSnorm(x);
+    out[1] = PackSnorm(y);
+}
+
+static float VertexScore(int cachePosition, int remainingTriangles) {
+    if (remainingTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // The last triangle's vertices score the same, whichever came first
+        if (cachePosition < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scaler = 1.0f/(VERTEX_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3)*scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Prefer vertices with few triangles left, so they leave the mesh early
+    return score + VALENCE_BOOST_SCALE*powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+}
+
+void OptimizeVertexCache(std::vector<unsigned short>& indices, int vertexCount) {
+    int triangleCount = (int)indices.size()/3;
+    if (triangleCount == 0) return;
+
+    // Triangles using each vertex, the first remaining[v] are not emitted yet
+    std::vector<int> remaining(vertexCount, 0);
+    for (unsigned short index : indices) remaining[index]++;
+
+    std::vector<int> offsets(vertexCount + 1, 0);
+    for (int v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<int> vertexTriangles(indices.size());
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (int t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) vertexTriangles[fill[indices[t*3 + k]]++] = t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (int v = 0; v < vertexCount; v++) vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = 0;
+    for (int t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+        if (triangleScore[t] > triangleScore[best]) best = t;
+    }
+
+    std::vector<unsigned short> output;
+    output.reserve(indices.size());
+    std::vector<int> cache;
+    std::vector<int> nextCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+    int nextScan = 0;
+
+    for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        // Nothing in the cache touches a remaining triangle, scan for one
+        if (best < 0) {
+            while (emitted[nextScan]) nextScan++;
+            best = nextScan;
+            for (int t = nextScan; t < triangleCount; t++) {
+                if (!emitted[t] && triangleScore[t] > triangleScore[best]) best = t;
+            }
+        }
+
+        emitted[best] = true;
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            int v = indices[best*3 + k];
+            output.push_back((unsigned short)v);
+            nextCache.push_back(v);
+
+            // Move the triangle past this vertex's remaining ones
+            int* first = &vertexTriangles[offsets[v]];
+            int* last = first + remaining[v] - 1;
+            std::iter_swap(std::find(first, last + 1, best), last);
+            remaining[v]--;
+        }
+
+        // Emitted vertices move to the front, the oldest fall out
+        for (int v : cache) {
+            if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) nextCache.push_back(v);
+        }
+        for (int i = 0; i < (int)nextCache.size(); i++) {
+            int v = nextCache[i];
+            cachePosition[v] = (i < VERTEX_CACHE_SIZE) ? i : -1;
+            vertexScore[v] = VertexScore(cachePosition[v], remaining[v]);
+        }
+
+        // Rescore the triangles around the cache and pick the next one
+        best = -1;
+        for (int v : nextCache) {
+            for (int i = 0; i < remaining[v]; i++) {
+                int t = vertexTriangles[offsets[v] + i];
+                triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+                if (best < 0 || triangleScore[t] > triangleScore[best]) best = t;
+            }
+        }
+
+        if ((int)nextCache.size() > VERTEX_CACHE_SIZE) nextCache.resize(VERTEX_CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+
+    indices.swap(output);
+}
+
+float ComputeCacheMissRatio(const std::vector<unsigned short>& indices, int vertexCount, int cacheSize) {
+    if (indices.empty()) return 0.0f;
+
+    // FIFO: remember when each vertex entered the cache
+    std::vector<int> entered(vertexCount, -cacheSize - 1);
+    int misses = 0;
+    for (unsigned short index : indices) {
+        if (misses - entered[index] > cacheSize) {
+            entered[index] = misses;
+            misses++;
+        }
+    }
+    return (float)misses/(float)(indices.size()/3);
+}
+
+Mesh GenMeshCompactSphere(int rings, int slices) {
+    Mesh mesh = { 0 };
+    rings = std::max(rings, 2);
+    slices = std::max(slices, 3);
+
+    // The seam and the poles have a vertex per slice for their own uv
+    int vertexCount = (rings + 1)*(slices + 1);
+    if (vertexCount > 65536) {
+        TraceLog(LOG_WARNING, "SPHERE: %i x %i sphere needs more than 16-bit indices", rings, slices);
+        return mesh;
+    }
+
+    // v runs from the north pole (+y) to the south pole, u = 0.5 - atan2(z, x)/2pi
+    std::vector<CompactVertex> vertices(vertexCount);
+    for (int ring = 0; ring <= rings; ring++) {
+        float v = (float)ring/rings;
+        float theta = v*PI;
+        for (int slice = 0; slice <= slices; slice++) {
+            float u = (float)slice/slices;
+            float phi = (0.5f - u)*2.0f*PI;
+
+            Vector3 normal = { sinf(theta)*cosf(phi), cosf(theta), sinf(theta)*sinf(phi) };
+            Vector3 tangent = { sinf(phi), 0.0f, -cosf(phi) };     // Along +u
+            Vector3 north = { -cosf(theta)*cosf(phi), sinf(theta), -cosf(theta)*sinf(phi) };     // Along -v
+
+            // Bitangent is cross(normal, tangent)*handedness, pointing up the image
+            Vector3 cross = { normal.y*tangent.z - normal.z*tangent.y,
+                              normal.z*tangent.x - normal.x*tangent.z,
+                              normal.x*tangent.y - normal.y*tangent.x };
+            float handedness = (cross.x*north.x + cross.y*north.y + cross.z*north.z >= 0.0f) ? 1.0f : -1.0f;
+
+            CompactVertex& vertex = vertices[ring*(slices + 1) + slice];
+            vertex.position[0] = PackSnorm(normal.x);
+            vertex.position[1] = PackSnorm(normal.y);
+            vertex.position[2] = PackSnorm(normal.z);
+            vertex.position[3] = 0;
+            PackOctahedral(normal, vertex.normal);
+            PackOctahedral(tangent, vertex.tangent);
+            vertex.tangent[2] = PackSnorm(handedness);
+            vertex.tangent[3] = 0;
+            vertex.texcoord[0] = PackUnorm(u);
+            vertex.texcoord[1] = PackUnorm(v);
+        }
+    }
+
+    // Counter-clockwise seen from outside, pole rings have one triangle per quad
+    std::vector<unsigned short> indices;
+    for (int ring = 0; ring < rings; ring++) {
+        for (int slice = 0; slice < slices; slice++) {
+            unsigned short a = (unsigned short)(ring*(slices + 1) + slice);
+            unsigned short b = (unsigned short)(a + slices + 1);
+            unsigned short c = (unsigned short)(a + 1);
+            unsigned short d = (unsigned short)(b + 1);
+            if (ring != 0) indices.insert(indices.end(), { a, b, c });
+            if (ring != rings - 1) indices.insert(indices.end(), { c, b, d });
+        }
+    }
+
+    float missRatioBefore = ComputeCacheMissRatio(indices, vertexCount, 16);
+    OptimizeVertexCache(indices, vertexCount);
+    float missRatioAfter = ComputeCacheMissRatio(indices, vertexCount, 16);
+
+    // Renumber vertices in first use order so fetches walk the buffer forward
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<CompactVertex> ordered;
+    ordered.reserve(vertexCount);
+    for (unsigned short& index : indices) {
+        if (remap[index] < 0) {
+            remap[index] = (int)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = (unsigned short)remap[index];
+    }
+
+    mesh.vertexCount = (int)ordered.size();
+    mesh.triangleCount = (int)indices.size()/3;
+
+    // UnloadMesh frees the index copy and every buffer id
+    mesh.indices = (unsigned short*)MemAlloc((unsigned int)(indices.size()*sizeof(unsigned short)));
+    std::copy(indices.begin(), indices.end(), mesh.indices);
+    mesh.vboId = (unsigned int*)MemAlloc(MAX_MESH_VERTEX_BUFFERS*sizeof(unsigned int));
+
+    int stride = (int)sizeof(CompactVertex);
+    mesh.vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(mesh.vaoId);
+    mesh.vboId[0] = rlLoadVertexBuffer(ordered.data(), (int)(ordered.size()*sizeof(CompactVertex)), false);
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, GL_SHORT, true, stride, (int)offsetof(CompactVertex, position));
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, GL_UNSIGNED_SHORT, true, stride, (int)offsetof(CompactVertex, texcoord));
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 2, GL_SHORT, true, stride, (int)offsetof(CompactVertex, normal));
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL);
+    rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, 3, GL_SHORT, true, stride, (int)offsetof(CompactVertex, tangent));
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT);
+    mesh.vboId[RL_DEFAULT_SHADER_ATTRIB_LOCATION_INDICES] = rlLoadVertexBufferElement(mesh.indices, (int)(indices.size()*sizeof(unsigned short)), false);
+    rlDisableVertexArray();
+
+    TraceLog(LOG_INFO, "SPHERE: %i vertices, %i triangles, %i bytes per vertex, cache miss ratio %.3f -> %.3f",
+             mesh.vertexCount, mesh.triangleCount, stride, missRatioBefore, missRatioAfter);
+    return mesh;
+}
@@ -0,0 +1,29 @@
+#ifndef SPHERE_MESH_H
+#define SPHERE_MESH_H
+
+#include "raylib.h"
+#include <vector>
+
+// Compact vertex, 24 bytes instead of 48 for float position, normal,
+// tangent and texcoord. basic.vs decodes it when compactVertices is set.
+struct CompactVertex {
+    short position[4];          // snorm16 xyz of the unit sphere, w unused
+    short normal[2];            // snorm16 octahedral
+    short tangent[4];           // snorm16 octahedral xy, handedness z, w unused
+    unsigned short texcoord[2]; // unorm16
+};
+
+// Generate an indexed unit UV sphere (same UV layout as sphere.glb) in the
+// compact vertex format, with triangles ordered for the post-transform
+// vertex cache. The mesh is uploaded and works with DrawMesh/UnloadMesh,
+// but has no CPU side vertex arrays.
+Mesh GenMeshCompactSphere(int rings, int slices);
+
+// Reorder triangles for the vertex cache (Forsyth's linear speed algorithm)
+void OptimizeVertexCache(std::vector<unsigned short>& indices, int vertexCount);
+
+// Average cache miss ratio (transformed vertices per triangle) of a FIFO
+// cache with cacheSize entries
+float ComputeCacheMissRatio(const std::vector<unsigned short>& indices, int vertexCount, int cacheSize);
+
+#endif // SPHERE_MESH_H
@@ -0,0 +1,320 @@
+#include "TelemetryPublisher.h"
+#include "raylib.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Map an existing region read-only for a reader
+static void* MapRegion(const char* name, void** mapping) {
+    size_t size = sizeof(TelemetryRegion);
+#ifdef _WIN32
+    HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (handle == nullptr) return nullptr;
+
+    void* memory = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, size);
+    if (memory == nullptr) {
+        CloseHandle(handle);
+        return nullptr;
+    }
+    *mapping = handle;
+    return memory;
+#else
+    (void)mapping;
+    char path[80];
+    snprintf(path, sizeof(path), "/%s", name);
+
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    bool sized = (fstat(fd, &info) == 0 && (size_t)info.st_size >= size);
+    void* memory = sized ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    return (memory == MAP_FAILED) ? nullptr : memory;
+#endif
+}
+
+#ifndef _WIN32
+// Owner of an existing region, 0 if it has no valid header of this layout
+static uint32_t GetRegionOwner(const char* name) {
+    void* memory = MapRegion(name, nullptr);
+    if (memory == nullptr) return 0;
+
+    const TelemetryRegion* region = static_cast<const TelemetryRegion*>(memory);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t owner = (region->magic == TELEMETRY_MAGIC && region->version == TELEMETRY_VERSION) ? region->writerProcess : 0;
+    munmap(memory, sizeof(TelemetryRegion));
+    return owner;
+}
+#endif
+
+// Create the writer's region. It is never shared with another writer:
+// resetting the slots under a live publisher would corrupt its stream.
+static void* CreateRegion(const char* name, void** mapping) {
+    size_t size = sizeof(TelemetryRegion);
+#ifdef _WIN32
+    // Mappings disappear with their last handle, so an existing one is live
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)size, name);
+    if (handle == nullptr) return nullptr;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        TraceLog(LOG_WARNING, "TELEMETRY: Region %s is in use by another publisher", name);
+        CloseHandle(handle);
+        return nullptr;
+    }
+
+    void* memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (memory == nullptr) {
+        CloseHandle(handle);
+        return nullptr;
+    }
+    *mapping = handle;
+    return memory;
+#else
+    (void)mapping;
+    char path[80];
+    snprintf(path, sizeof(path), "/%s", name);
+
+    // POSIX objects outlive a crashed writer, replace those once
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd >= 0) {
+            bool sized = (ftruncate(fd, (off_t)size) == 0);
+            void* memory = sized ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (memory != MAP_FAILED) return memory;
+            shm_unlink(path);
+            return nullptr;
+        }
+        if (errno != EEXIST) return nullptr;
+
+        // A publisher starting up right now may not have written its header
+        uint32_t owner = GetRegionOwner(name);
+        if (owner == 0) {
+            usleep(100000);
+            owner = GetRegionOwner(name);
+        }
+        if (owner != 0 && (kill((pid_t)owner, 0) == 0 || errno == EPERM)) {
+            TraceLog(LOG_WARNING, "TELEMETRY: Region %s is in use by publisher process %u", path, owner);
+            return nullptr;
+        }
+
+        if (owner != 0) {
+            TraceLog(LOG_INFO, "TELEMETRY: Removing stale region %s left by process %u", path, owner);
+        } else {
+            TraceLog(LOG_INFO, "TELEMETRY: Removing stale region %s with an unknown layout", path);
+        }
+        shm_unlink(path);
+    }
+    return nullptr;
+#endif
+}
+
+static void UnmapRegion(const void* memory, void* mapping) {
+#ifdef _WIN32
+    UnmapViewOfFile(memory);
+    CloseHandle((HANDLE)mapping);
+#else
+    (void)mapping;
+    munmap(const_cast<void*>(memory), sizeof(TelemetryRegion));
+#endif
+}
+
+TelemetryPublisher::TelemetryPublisher()
+    : region(nullptr),
+      activeSlot(nullptr),
+      activeSequence(0)
+{
+    name[0] = '\0';
+#ifdef _WIN32
+    mapping = nullptr;
+#endif
+}
+
+TelemetryPublisher::~TelemetryPublisher() {
+    Close();
+}
+
+bool TelemetryPublisher::Open(const char* newName) {
+    Close();
+
+    void* handle = nullptr;
+    void* memory = CreateRegion(newName, &handle);
+    if (memory == nullptr) return false;
+
+    snprintf(name, sizeof(name), "%s", newName);
+#ifdef _WIN32
+    mapping = handle;
+#endif
+
+    // Publish the layout last so readers never see a half initialized header
+    region = static_cast<TelemetryRegion*>(memory);
+    memset(static_cast<void*>(region->slots), 0, sizeof(region->slots));
+    region->published.store(0, std::memory_order_relaxed);
+    region->version = TELEMETRY_VERSION;
+    region->slotCount = TELEMETRY_SLOT_COUNT;
+    region->maxBodies = TELEMETRY_MAX_BODIES;
+#ifdef _WIN32
+    region->writerProcess = (uint32_t)GetCurrentProcessId();
+#else
+    region->writerProcess = (uint32_t)getpid();
+#endif
+    region->reserved = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    region->magic = TELEMETRY_MAGIC;
+    return true;
+}
+
+void TelemetryPublisher::Close() {
+    if (region == nullptr) return;
+
+#ifdef _WIN32
+    UnmapRegion(region, mapping);
+    mapping = nullptr;
+#else
+    UnmapRegion(region, nullptr);
+    char path[80];
+    snprintf(path, sizeof(path), "/%s", name);
+    shm_unlink(path);
+#endif
+    region = nullptr;
+    activeSlot = nullptr;
+}
+
+bool TelemetryPublisher::IsOpen() const {
+    return region != nullptr;
+}
+
+TelemetryBodyState* TelemetryPublisher::BeginSnapshot(uint64_t tick, double simulationTime) {
+    if (region == nullptr) return nullptr;
+
+    uint64_t index = region->published.load(std::memory_order_relaxed);
+    activeSlot = &region->slots[index % TELEMETRY_SLOT_COUNT];
+
+    // Mark the slot as being written before touching its data
+    activeSequence = activeSlot->sequence.load(std::memory_order_relaxed) + 1;
+    activeSlot->sequence.store(activeSequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    activeSlot->snapshot.publishIndex = index;
+    activeSlot->snapshot.tick = tick;
+    activeSlot->snapshot.simulationTime = simulationTime;
+    return activeSlot->snapshot.bodies;
+}
+
+void TelemetryPublisher::EndSnapshot(int bodyCount) {
+    if (activeSlot == nullptr) return;
+
+    if (bodyCount < 0) bodyCount = 0;
+    if (bodyCount > TELEMETRY_MAX_BODIES) bodyCount = TELEMETRY_MAX_BODIES;
+    activeSlot->snapshot.bodyCount = (uint32_t)bodyCount;
+
+    activeSlot->sequence.store(activeSequence + 1, std::memory_order_release);
+    region->published.store(activeSlot->snapshot.publishIndex + 1, std::memory_order_release);
+    activeSlot = nullptr;
+}
+
+uint64_t TelemetryPublisher::GetPublishedCount() const {
+    return (region != nullptr) ? region->published.load(std::memory_order_relaxed) : 0;
+}
+
+const char* TelemetryPublisher::GetName() const {
+    return name;
+}
+
+TelemetryReader::TelemetryReader()
+    : region(nullptr)
+{
+#ifdef _WIN32
+    mapping = nullptr;
+#endif
+}
+
+TelemetryReader::~TelemetryReader() {
+    Close();
+}
+
+bool TelemetryReader::Open(const char* name) {
+    Close();
+
+    void* handle = nullptr;
+    void* memory = MapRegion(name, &handle);
+    if (memory == nullptr) return false;
+
+    // Reject regions written with another layout
+    const TelemetryRegion* mapped = static_cast<const TelemetryRegion*>(memory);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mapped->magic != TELEMETRY_MAGIC || mapped->version != TELEMETRY_VERSION ||
+        mapped->slotCount != TELEMETRY_SLOT_COUNT || mapped->maxBodies != TELEMETRY_MAX_BODIES) {
+        UnmapRegion(memory, handle);
+        return false;
+    }
+
+    region = mapped;
+#ifdef _WIN32
+    mapping = handle;
+#endif
+    return true;
+}
+
+void TelemetryReader::Close() {
+    if (region == nullptr) return;
+
+#ifdef _WIN32
+    UnmapRegion(region, mapping);
+    mapping = nullptr;
+#else
+    UnmapRegion(region, nullptr);
+#endif
+    region = nullptr;
+}
+
+bool TelemetryReader::IsOpen() const {
+    return region != nullptr;
+}
+
+bool TelemetryReader::Read(uint64_t publishIndex, TelemetrySnapshot& snapshot) const {
+    if (region == nullptr) return false;
+
+    uint64_t published = region->published.load(std::memory_order_acquire);
+    if (publishIndex >= published || published - publishIndex > TELEMETRY_SLOT_COUNT) return false;
+
+    const TelemetrySlot& slot = region->slots[publishIndex % TELEMETRY_SLOT_COUNT];
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        memcpy(&snapshot, &slot.snapshot, sizeof(TelemetrySnapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // A changed sequence means the writer reused the slot meanwhile
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return snapshot.publishIndex == publishIndex;
+        }
+    }
+    return false;
+}
+
+bool TelemetryReader::ReadLatest(TelemetrySnapshot& snapshot) const {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint64_t published = GetPublishedCount();
+        if (published == 0) return false;
+        if (Read(published - 1, snapshot)) return true;
+    }
+    return false;
+}
+
+uint64_t TelemetryReader::GetPublishedCount() const {
+    return (region != nullptr) ? region->published.load(std::memory_order_acquire) : 0;
+}
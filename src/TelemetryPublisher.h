@@ -0,0 +1,115 @@
+#ifndef TELEMETRY_PUBLISHER_H
+#define TELEMETRY_PUBLISHER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Shared memory layout, external readers can include this header on its own
+#define TELEMETRY_MAGIC 0x4D545352u     // "RSTM"
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_SLOT_COUNT 16
+#define TELEMETRY_MAX_BODIES 64
+#define TELEMETRY_NAME_LENGTH 32
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Telemetry needs address-free 64-bit atomics");
+
+// State of one body, world units
+struct TelemetryBodyState {
+    uint32_t id;
+    char name[TELEMETRY_NAME_LENGTH];
+    float position[3];
+    float orientation[4];       // Quaternion x, y, z, w
+    float radius;
+};
+
+// Everything published for one simulation tick
+struct TelemetrySnapshot {
+    uint64_t publishIndex;      // Position in the stream of snapshots
+    uint64_t tick;
+    double simulationTime;
+    uint32_t bodyCount;
+    uint32_t reserved;
+    TelemetryBodyState bodies[TELEMETRY_MAX_BODIES];
+};
+
+// Seqlock: odd while the writer is inside the slot
+struct TelemetrySlot {
+    std::atomic<uint32_t> sequence;
+    uint32_t reserved;
+    TelemetrySnapshot snapshot;
+};
+
+struct TelemetryRegion {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t maxBodies;
+    uint32_t writerProcess;             // Publisher's process id, tells live regions from stale ones
+    uint32_t reserved;
+    std::atomic<uint64_t> published;    // Snapshots written so far
+    TelemetrySlot slots[TELEMETRY_SLOT_COUNT];
+};
+
+// Writes per-tick snapshots into a shared memory ring. There is a single
+// writer and any number of readers, readers never block the writer: they
+// retry or skip a slot whose sequence changed while they copied it.
+class TelemetryPublisher {
+public:
+    // Constructor/Destructor
+    TelemetryPublisher();
+    ~TelemetryPublisher();
+
+    // Create the shared memory object (a POSIX shm name without the leading
+    // slash, or a Windows file mapping name). Fails if a running publisher
+    // owns it; a region left behind by a dead one is replaced.
+    bool Open(const char* name);
+    void Close();
+    bool IsOpen() const;
+
+    // Write a snapshot in place: fill the returned bodies, then end it.
+    // Readers ignore the slot until EndSnapshot is called.
+    TelemetryBodyState* BeginSnapshot(uint64_t tick, double simulationTime);
+    void EndSnapshot(int bodyCount);
+
+    uint64_t GetPublishedCount() const;
+    const char* GetName() const;
+
+private:
+    TelemetryRegion* region;
+    TelemetrySlot* activeSlot;
+    uint32_t activeSequence;
+    char name[64];
+#ifdef _WIN32
+    void* mapping;
+#endif
+};
+
+// Reader side for external tools
+class TelemetryReader {
+public:
+    // Constructor/Destructor
+    TelemetryReader();
+    ~TelemetryReader();
+
+    bool Open(const char* name);
+    void Close();
+    bool IsOpen() const;
+
+    // Copy the newest snapshot, false if none is published yet
+    bool ReadLatest(TelemetrySnapshot& snapshot) const;
+
+    // Copy snapshot publishIndex, false if it is not written yet or was
+    // already overwritten by the ring
+    bool Read(uint64_t publishIndex, TelemetrySnapshot& snapshot) const;
+
+    uint64_t GetPublishedCount() const;
+
+private:
+    const TelemetryRegion* region;
+#ifdef _WIN32
+    void* mapping;
+#endif
+};
+
+#endif // TELEMETRY_PUBLISHER_H
@@ -0,0 +1,382 @@
+#include "TextureResidency.h"
+#include "rlgl.h"
+#include "external/glad.h"
+#include <algorithm>
+
+// Largest dimension of the mip tail that always stays resident
+static const int TAIL_SIZE = 64;
+
+static int MipDimension(int size, int mip) {
+    int result = size >> mip;
+    return (result < 1) ? 1 : result;
+}
+
+TextureResidency::TextureResidency(size_t budgetBytes)
+    : budget(budgetBytes),
+      coldFrames(120),
+      frameIndex(0),
+      maxUploadsPerFrame(1),
+      copyFramebuffers{ 0, 0 },
+      stopLoader(false)
+{
+    loaderThread = std::thread(&TextureResidency::LoaderLoop, this);
+}
+
+TextureResidency::~TextureResidency() {
+    Unload();
+}
+
+void TextureResidency::Unload() {
+    // Stop the loader thread
+    if (loaderThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            stopLoader = true;
+        }
+        loaderCondition.notify_all();
+        loaderThread.join();
+    }
+
+    // Drop loads that were never uploaded
+    for (LoadResult& result : loadResults) {
+        UnloadImage(result.image);
+    }
+    loadResults.clear();
+    loadQueue.clear();
+
+    // Release textures and CPU mip tails
+    for (Entry& entry : entries) {
+        if (entry.texture.id > 0) UnloadTexture(entry.texture);
+        if (entry.tailImage.data != nullptr) UnloadImage(entry.tailImage);
+    }
+    entries.clear();
+
+    if (copyFramebuffers[0] != 0) {
+        glDeleteFramebuffers(2, copyFramebuffers);
+        copyFramebuffers[0] = 0;
+        copyFramebuffers[1] = 0;
+    }
+}
+
+TextureHandle TextureResidency::Register(const char* path) {
+    Image image = LoadImage(path);
+    if (image.data == nullptr) {
+        TraceLog(LOG_WARNING, "RESIDENCY: Failed to load texture %s", path);
+        return INVALID_TEXTURE_HANDLE;
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.baseWidth = image.width;
+    entry.baseHeight = image.height;
+    entry.format = image.format;
+
+    // Number of mips in a full chain down to 1x1
+    int largest = std::max(image.width, image.height);
+    entry.mipCount = 1;
+    while ((largest >> entry.mipCount) > 0) entry.mipCount++;
+
+    // Pick the mip tail
+    entry.tailMip = 0;
+    while ((largest >> entry.tailMip) > TAIL_SIZE && entry.tailMip < entry.mipCount - 1) {
+        entry.tailMip++;
+    }
+
+    // Build the tail from the already decoded image
+    ImageResize(&image, MipDimension(entry.baseWidth, entry.tailMip), MipDimension(entry.baseHeight, entry.tailMip));
+    ImageMipmaps(&image);
+    entry.tailImage = image;
+    entry.texture = LoadTextureFromImage(entry.tailImage);
+    SetTextureFilter(entry.texture, TEXTURE_FILTER_TRILINEAR);
+
+    entry.residentMip = entry.tailMip;
+    entry.requiredMip = entry.tailMip;
+    entry.targetMip = entry.tailMip;
+    entry.pendingMip = -1;
+    entry.lastUsedFrame = frameIndex;
+
+    entries.push_back(entry);
+    return (TextureHandle)entries.size() - 1;
+}
+
+void TextureResidency::RequestWidth(TextureHandle handle, float requiredWidth) {
+    if (handle < 0 || handle >= (int)entries.size()) return;
+    Entry& entry = entries[handle];
+
+    // Finest mip that is still at least as wide as required
+    int mip = 0;
+    float width = (float)entry.baseWidth;
+    while (mip < entry.tailMip && width * 0.5f >= requiredWidth) {
+        width *= 0.5f;
+        mip++;
+    }
+
+    // Several draws can share a texture, keep the sharpest request
+    if (entry.lastUsedFrame != frameIndex || mip < entry.requiredMip) {
+        entry.requiredMip = mip;
+    }
+    entry.lastUsedFrame = frameIndex;
+}
+
+Texture2D TextureResidency::GetTexture(TextureHandle handle) const {
+    if (handle < 0 || handle >= (int)entries.size()) return Texture2D{ 0 };
+    return entries[handle].texture;
+}
+
+void TextureResidency::Update() {
+    // Swap in mips finished by the loader thread
+    UploadResults();
+
+    // Decide which mip each texture should have
+    ApplyBudget();
+
+    for (TextureHandle handle = 0; handle < (int)entries.size(); handle++) {
+        Entry& entry = entries[handle];
+        if (entry.pendingMip != -1 || entry.targetMip == entry.residentMip) continue;
+
+        if (entry.targetMip == entry.tailMip) {
+            // Dropping to the tail needs no disk access
+            UnloadTexture(entry.texture);
+            entry.texture = LoadTextureFromImage(entry.tailImage);
+            SetTextureFilter(entry.texture, TEXTURE_FILTER_TRILINEAR);
+            entry.residentMip = entry.tailMip;
+        } else if (entry.targetMip < entry.residentMip || !CopyResidentMips(entry, entry.targetMip)) {
+            QueueLoad(handle, entry.targetMip);
+        }
+    }
+
+    frameIndex++;
+}
+
+size_t TextureResidency::MipChainBytes(const Entry& entry, int mip) const {
+    size_t bytes = 0;
+    for (int level = mip; level < entry.mipCount; level++) {
+        bytes += GetPixelDataSize(MipDimension(entry.baseWidth, level), MipDimension(entry.baseHeight, level), entry.format);
+    }
+    return bytes;
+}
+
+void TextureResidency::ApplyBudget() {
+    size_t total = 0;
+    for (Entry& entry : entries) {
+        bool isCold = (frameIndex - entry.lastUsedFrame) > coldFrames;
+        entry.targetMip = isCold ? entry.tailMip : entry.requiredMip;
+        total += MipChainBytes(entry, entry.targetMip);
+    }
+
+    if (total <= budget) return;
+
+    // Over budget: downgrade least recently used textures first
+    budgetOrder.resize(entries.size());
+    for (TextureHandle handle = 0; handle < (int)entries.size(); handle++) {
+        budgetOrder[handle] = handle;
+    }
+    std::sort(budgetOrder.begin(), budgetOrder.end(), [this](TextureHandle a, TextureHandle b) {
+        return entries[a].lastUsedFrame < entries[b].lastUsedFrame;
+    });
+
+    for (TextureHandle handle : budgetOrder) {
+        Entry& entry = entries[handle];
+        while (total > budget && entry.targetMip < entry.tailMip) {
+            total -= MipChainBytes(entry, entry.targetMip);
+            entry.targetMip++;
+            total += MipChainBytes(entry, entry.targetMip);
+        }
+        if (total <= budget) break;
+    }
+}
+
+void TextureResidency::QueueLoad(TextureHandle handle, int mip) {
+    Entry& entry = entries[handle];
+    entry.pendingMip = mip;
+
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        loadQueue.push_back(LoadRequest{ handle, mip, entry.path, entry.baseWidth, entry.baseHeight });
+    }
+    loaderCondition.notify_one();
+}
+
+void TextureResidency::UploadResults() {
+    // Limit uploads to keep frame times stable
+    for (int upload = 0; upload < maxUploadsPerFrame; upload++) {
+        LoadResult result;
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            if (loadResults.empty()) return;
+            result = loadResults.front();
+            loadResults.pop_front();
+        }
+
+        Entry& entry = entries[result.handle];
+        entry.pendingMip = -1;
+
+        // Discard loads that the budget no longer wants
+        if (result.image.data != nullptr && result.mip == entry.targetMip) {
+            Texture2D texture = LoadTextureFromImage(result.image);
+            if (texture.id > 0) {
+                SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+                UnloadTexture(entry.texture);
+                entry.texture = texture;
+                entry.residentMip = result.mip;
+            }
+        }
+
+        UnloadImage(result.image);
+    }
+}
+
+void TextureResidency::LoaderLoop() {
+    while (true) {
+        LoadRequest request;
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+            loaderCondition.wait(lock, [this] { return stopLoader || !loadQueue.empty(); });
+            if (stopLoader) return;
+            request = loadQueue.front();
+            loadQueue.pop_front();
+        }
+
+        // Decode and downsample off the render thread
+        Image image = LoadMipChain(request.path, request.baseWidth, request.baseHeight, request.mip);
+
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        loadResults.push_back(LoadResult{ request.handle, request.mip, image });
+    }
+}
+
+Image TextureResidency::LoadMipChain(const std::string& path, int baseWidth, int baseHeight, int mip) {
+    Image image = LoadImage(path.c_str());
+    if (image.data == nullptr) return image;
+
+    if (mip > 0) {
+        ImageResize(&image, MipDimension(baseWidth, mip), MipDimension(baseHeight, mip));
+    }
+    ImageMipmaps(&image);
+    return image;
+}
+
+bool TextureResidency::CopyResidentMips(Entry& entry, int mip) {
+    // Compressed formats can not be attached to a framebuffer
+    if (entry.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) return false;
+
+    // The lower chain is a suffix of the resident one: blit it into a smaller
+    // texture on the GPU, no disk access and no CPU copy of the texels
+    int skip = mip - entry.residentMip;
+    int mipmaps = entry.texture.mipmaps - skip;
+    if (skip <= 0 || mipmaps <= 0) return false;
+
+    Texture2D texture = { 0 };
+    texture.width = MipDimension(entry.texture.width, skip);
+    texture.height = MipDimension(entry.texture.height, skip);
+    texture.mipmaps = mipmaps;
+    texture.format = entry.texture.format;
+
+    unsigned int glInternalFormat, glFormat, glType;
+    rlGetGlTextureFormats(texture.format, &glInternalFormat, &glFormat, &glType);
+    if (glInternalFormat == 0) return false;
+
+    rlDrawRenderBatchActive();
+    GLint previousRead = 0, previousDraw = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    if (copyFramebuffers[0] == 0) glGenFramebuffers(2, copyFramebuffers);
+
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    for (int level = 0; level < mipmaps; level++) {
+        glTexImage2D(GL_TEXTURE_2D, level, glInternalFormat, MipDimension(texture.width, level),
+                     MipDimension(texture.height, level), 0, glFormat, glType, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmaps - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    bool complete = true;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFramebuffers[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, copyFramebuffers[1]);
+    for (int level = 0; level < mipmaps && complete; level++) {
+        int width = MipDimension(texture.width, level);
+        int height = MipDimension(texture.height, level);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, entry.texture.id, level + skip);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id, level);
+        complete = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE &&
+                   glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (complete) glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+
+    if (!complete) {
+        TraceLog(LOG_WARNING, "RESIDENCY: Format %i not blittable, reloading %s from disk", texture.format, entry.path.c_str());
+        glDeleteTextures(1, &texture.id);
+        return false;
+    }
+
+    SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+    UnloadTexture(entry.texture);
+    entry.texture = texture;
+    entry.residentMip = mip;
+    return true;
+}
+
+void TextureResidency::SetBudget(size_t budgetBytes) {
+    budget = budgetBytes;
+}
+
+size_t TextureResidency::GetBudget() const {
+    return budget;
+}
+
+void TextureResidency::SetColdFrames(unsigned int frames) {
+    coldFrames = frames;
+}
+
+unsigned int TextureResidency::GetColdFrames() const {
+    return coldFrames;
+}
+
+size_t TextureResidency::GetResidentBytes() const {
+    size_t bytes = 0;
+    for (const Entry& entry : entries) {
+        bytes += MipChainBytes(entry, entry.residentMip);
+    }
+    return bytes;
+}
+
+size_t TextureResidency::GetTargetBytes() const {
+    size_t bytes = 0;
+    for (const Entry& entry : entries) {
+        bytes += MipChainBytes(entry, entry.targetMip);
+    }
+    return bytes;
+}
+
+int TextureResidency::GetPendingLoads() const {
+    int pending = 0;
+    for (const Entry& entry : entries) {
+        if (entry.pendingMip != -1) pending++;
+    }
+    return pending;
+}
+
+int TextureResidency::GetTextureCount() const {
+    return (int)entries.size();
+}
+
+TextureResidencyStats TextureResidency::GetStats(TextureHandle handle) const {
+    const Entry& entry = entries[handle];
+
+    TextureResidencyStats stats;
+    stats.path = entry.path.c_str();
+    stats.baseWidth = entry.baseWidth;
+    stats.baseHeight = entry.baseHeight;
+    stats.mipCount = entry.mipCount;
+    stats.residentMip = entry.residentMip;
+    stats.requiredMip = entry.requiredMip;
+    stats.targetMip = entry.targetMip;
+    stats.residentBytes = MipChainBytes(entry, entry.residentMip);
+    stats.framesSinceUse = frameIndex - entry.lastUsedFrame;
+    return stats;
+}
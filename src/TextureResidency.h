@@ -0,0 +1,125 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include "raylib.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Handle to a texture owned by the residency manager
+typedef int TextureHandle;
+const TextureHandle INVALID_TEXTURE_HANDLE = -1;
+
+// Per-texture statistics shown in the memory panel
+struct TextureResidencyStats {
+    const char* path;
+    int baseWidth;
+    int baseHeight;
+    int mipCount;
+    int residentMip;      // Highest resolution mip currently on the GPU
+    int requiredMip;      // Mip requested by the last draw
+    int targetMip;        // Mip the manager is streaming towards
+    size_t residentBytes;
+    unsigned int framesSinceUse;
+};
+
+// Keeps body textures within a VRAM budget. Every texture always has its
+// low resolution mip tail resident; higher mips are streamed in from disk
+// on a loader thread when a body needs them and dropped again when the
+// texture goes cold or the budget is exceeded (least recently used first).
+class TextureResidency {
+public:
+    // Constructor/Destructor
+    TextureResidency(size_t budgetBytes);
+    ~TextureResidency();
+
+    // Register a texture file, loads its mip tail synchronously
+    TextureHandle Register(const char* path);
+
+    // Report the texel width a draw needs this frame
+    void RequestWidth(TextureHandle handle, float requiredWidth);
+
+    // Current GPU texture for a handle (id changes when mips are streamed)
+    Texture2D GetTexture(TextureHandle handle) const;
+
+    // Apply budget, queue loads and upload finished mips. Call once per frame.
+    void Update();
+
+    // Stop the loader thread and release all GPU textures (before CloseWindow)
+    void Unload();
+
+    // Budget settings
+    void SetBudget(size_t budgetBytes);
+    size_t GetBudget() const;
+    void SetColdFrames(unsigned int frames);
+    unsigned int GetColdFrames() const;
+
+    // Memory statistics
+    size_t GetResidentBytes() const;
+    size_t GetTargetBytes() const;
+    int GetPendingLoads() const;
+    int GetTextureCount() const;
+    TextureResidencyStats GetStats(TextureHandle handle) const;
+
+private:
+    struct Entry {
+        std::string path;
+        int baseWidth;
+        int baseHeight;
+        int format;
+        int mipCount;
+        int tailMip;          // Smallest mip kept resident at all times
+        int residentMip;
+        int requiredMip;
+        int targetMip;
+        int pendingMip;       // Mip being loaded, -1 if none
+        unsigned int lastUsedFrame;
+        Texture2D texture;
+        Image tailImage;      // CPU copy of the mip tail for instant downgrades
+    };
+
+    struct LoadRequest {
+        TextureHandle handle;
+        int mip;
+        std::string path;
+        int baseWidth;
+        int baseHeight;
+    };
+
+    struct LoadResult {
+        TextureHandle handle;
+        int mip;
+        Image image;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<TextureHandle> budgetOrder;
+    size_t budget;
+    unsigned int coldFrames;
+    unsigned int frameIndex;
+    int maxUploadsPerFrame;
+    unsigned int copyFramebuffers[2]; // Read and draw framebuffers for GPU mip copies
+
+    // Loader thread state
+    std::thread loaderThread;
+    std::mutex loaderMutex;
+    std::condition_variable loaderCondition;
+    std::deque<LoadRequest> loadQueue;
+    std::deque<LoadResult> loadResults;
+    bool stopLoader;
+
+    // Helper methods
+    size_t MipChainBytes(const Entry& entry, int mip) const;
+    void ApplyBudget();
+    void QueueLoad(TextureHandle handle, int mip);
+    void UploadResults();
+    void LoaderLoop();
+    static Image LoadMipChain(const std::string& path, int baseWidth, int baseHeight, int mip);
+    bool CopyResidentMips(Entry& entry, int mip);
+};
+
+#endif // TEXTURE_RESIDENCY_H
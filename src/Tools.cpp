@@ -88,3 +88,44 @@ TextureCubemap GenTextureCubemap(Shader shader, Texture2D panorama, int size, in
 
     return cubemap;
 }
+
+// Get the view-projection matrix used for scene geometry
+Matrix GetViewProjectionMatrix(const Camera3D& camera)
+{
+    Matrix matView = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix matProjection = MatrixPerspective(camera.fovy*DEG2RAD,
+                                           (float)GetScreenWidth()/(float)GetScreenHeight(),
+                                           SCENE_NEAR_PLANE, SCENE_FAR_PLANE);
+    return MatrixMultiply(matView, matProjection);
+}
+
+bool IsSphereInFrustum(const Matrix& viewProjection, const Vector3& center, float radius)
+{
+    // Frustum planes are sums and differences of the clip matrix rows
+    const Matrix& m = viewProjection;
+    Vector4 row0 = { m.m0, m.m4, m.m8, m.m12 };
+    Vector4 row1 = { m.m1, m.m5, m.m9, m.m13 };
+    Vector4 row2 = { m.m2, m.m6, m.m10, m.m14 };
+    Vector4 row3 = { m.m3, m.m7, m.m11, m.m15 };
+    Vector4 planes[6] = {
+        Vector4Add(row3, row0), Vector4Subtract(row3, row0),
+        Vector4Add(row3, row1), Vector4Subtract(row3, row1),
+        Vector4Add(row3, row2), Vector4Subtract(row3, row2)
+    };
+
+    for (int i = 0; i < 6; i++) {
+        Vector3 normal = { planes[i].x, planes[i].y, planes[i].z };
+        float length = Vector3Length(normal);
+        if (Vector3DotProduct(normal, center) + planes[i].w < -radius*length) return false;
+    }
+    return true;
+}
+
+bool PrepareTestBody(int index, const Matrix& viewProjection, Matrix& model)
+{
+    Vector3 center = { cosf(index*0.1f)*index*0.001f, 0.0f, sinf(index*0.1f)*index*0.001f };
+    Matrix rotation = MatrixRotate(Vector3{ 0.0f, 1.0f, 0.0f }, index*0.01f);
+    model = MatrixMultiply(MatrixMultiply(MatrixScale(0.1f, 0.1f, 0.1f), rotation),
+                           MatrixTranslate(center.x, center.y, center.z));
+    return IsSphereInFrustum(viewProjection, center, 0.1f);
+}
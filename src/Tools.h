@@ -5,7 +5,21 @@
 #include "rlgl.h"
 #include "raymath.h"
 
+// Clip planes of the scene projection
+#define SCENE_NEAR_PLANE 0.1f
+#define SCENE_FAR_PLANE 100.0f
+
 // Generate cubemap texture from HDR texture
 TextureCubemap GenTextureCubemap(Shader shader, Texture2D panorama, int size, int format);
 
+// Get the view-projection matrix used for scene geometry
+Matrix GetViewProjectionMatrix(const Camera3D& camera);
+
+// Check a bounding sphere against the frustum of a view-projection matrix
+bool IsSphereInFrustum(const Matrix& viewProjection, const Vector3& center, float radius);
+
+// Same work as CelestialBody::PrepareDraw for a synthetic body on a spiral,
+// used by the job system scaling test. Returns whether it is visible.
+bool PrepareTestBody(int index, const Matrix& viewProjection, Matrix& model);
+
 #endif // TOOLS_H
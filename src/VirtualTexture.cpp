@@ -0,0 +1,496 @@
+#include "VirtualTexture.h"
+#include "rlgl.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t EMPTY_PAGE = 0xFFFFFFFFu;
+
+// Keep the physical atlas within common GPU texture size limits
+static const int MAX_ATLAS_SIZE = 8192;
+
+VirtualTexture::VirtualTexture()
+    : tilesPerSide(0),
+      slotSize(0),
+      tileBytes(0),
+      frameIndex(0),
+      maxUploadsPerFrame(16),
+      maxPendingPages(64),
+      indirectionDirty(false),
+      packFile(nullptr),
+      stopLoader(false)
+{
+    memset(&header, 0, sizeof(header));
+    indirectionTexture = { 0 };
+    physicalTexture = { 0 };
+}
+
+VirtualTexture::~VirtualTexture() {
+    Unload();
+}
+
+bool VirtualTexture::Load(const char* packPath, int cacheTilesPerSide) {
+    packFile = fopen(packPath, "rb");
+    if (packFile == nullptr) {
+        TraceLog(LOG_WARNING, "VT: Failed to open pack %s", packPath);
+        return false;
+    }
+
+    // Reject other versions and packs cut short by an interrupted build
+    int64_t expectedBytes = 0, fileBytes = 0;
+    if (fread(&header, sizeof(header), 1, packFile) == 1) {
+        expectedBytes = GetVirtualTexturePackBytes(header);
+        if (VT_FSEEK(packFile, 0, SEEK_END) == 0) fileBytes = VT_FTELL(packFile);
+    }
+    if (expectedBytes == 0 || fileBytes < expectedBytes) {
+        TraceLog(LOG_WARNING, "VT: Invalid pack %s (%lld of %lld bytes), rebuild it with VirtualTextureBake",
+                 packPath, (long long)fileBytes, (long long)expectedBytes);
+        fclose(packFile);
+        packFile = nullptr;
+        return false;
+    }
+
+    slotSize = header.tileSize + 2*header.border;
+    tileBytes = (size_t)header.layerCount*slotSize*slotSize*4;
+
+    // Layers sit side by side in the atlas
+    int maxTilesPerSide = std::min(MAX_ATLAS_SIZE/(slotSize*header.layerCount), MAX_ATLAS_SIZE/slotSize);
+    tilesPerSide = std::max(1, std::min(cacheTilesPerSide, maxTilesPerSide));
+
+    // First page index of every mip inside the pack
+    levelOffsets.resize(header.mipCount);
+    int pageCount = 0;
+    for (int mip = 0; mip < header.mipCount; mip++) {
+        levelOffsets[mip] = pageCount;
+        pageCount += LevelPagesX(mip)*LevelPagesY(mip);
+    }
+
+    slots.assign(tilesPerSide*tilesPerSide, Slot{ EMPTY_PAGE, 0, false });
+
+    // Indirection texels use the same page order as the pack, created once
+    // and then updated level by level as pages arrive
+    indirectionData.assign((size_t)pageCount*4, 0);
+    Image indirection = { indirectionData.data(), header.pagesX, header.pagesY, header.mipCount, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    indirectionTexture = LoadTextureFromImage(indirection);
+    SetTextureFilter(indirectionTexture, TEXTURE_FILTER_POINT);
+
+    // Physical atlas is allocated without data, tiles are uploaded into it
+    int atlasWidth = tilesPerSide*slotSize*header.layerCount;
+    int atlasHeight = tilesPerSide*slotSize;
+    physicalTexture.id = rlLoadTexture(nullptr, atlasWidth, atlasHeight, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    physicalTexture.width = atlasWidth;
+    physicalTexture.height = atlasHeight;
+    physicalTexture.mipmaps = 1;
+    physicalTexture.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    SetTextureFilter(physicalTexture, TEXTURE_FILTER_BILINEAR);
+
+    // Load the coarsest page up front so every texel has a fallback
+    int top = header.mipCount - 1;
+    std::vector<unsigned char> data(tileBytes);
+    VT_FSEEK(packFile, (int64_t)(sizeof(header) + (size_t)levelOffsets[top]*tileBytes), SEEK_SET);
+    if (fread(data.data(), 1, tileBytes, packFile) == tileBytes) {
+        UploadTile(PageKey(0, 0, top), data.data(), true);
+    }
+    RebuildIndirection();
+
+    stopLoader = false;
+    loaderThread = std::thread(&VirtualTexture::LoaderLoop, this);
+
+    TraceLog(LOG_INFO, "VT: Loaded %s (%ix%i pages, %i cache tiles)", packPath, header.pagesX, header.pagesY, tilesPerSide*tilesPerSide);
+    return true;
+}
+
+void VirtualTexture::Unload() {
+    // Stop the loader thread before closing the pack
+    if (loaderThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            stopLoader = true;
+        }
+        loaderCondition.notify_all();
+        loaderThread.join();
+    }
+
+    if (packFile != nullptr) {
+        fclose(packFile);
+        packFile = nullptr;
+    }
+
+    loadQueue.clear();
+    loadResults.clear();
+    pendingPages.clear();
+    residentPages.clear();
+    slots.clear();
+
+    if (indirectionTexture.id > 0) UnloadTexture(indirectionTexture);
+    if (physicalTexture.id > 0) UnloadTexture(physicalTexture);
+    indirectionTexture = { 0 };
+    physicalTexture = { 0 };
+}
+
+bool VirtualTexture::IsLoaded() const {
+    return physicalTexture.id > 0;
+}
+
+int VirtualTexture::LevelPagesX(int mip) const {
+    return std::max(header.pagesX >> mip, 1);
+}
+
+int VirtualTexture::LevelPagesY(int mip) const {
+    return std::max(header.pagesY >> mip, 1);
+}
+
+uint32_t VirtualTexture::PageKey(int pageX, int pageY, int mip) {
+    return ((uint32_t)mip << 24) | ((uint32_t)pageY << 12) | (uint32_t)pageX;
+}
+
+void VirtualTexture::RequestPage(int pageX, int pageY, int mip) {
+    if (!IsLoaded() || mip < 0 || mip >= header.mipCount) return;
+    if (pageX < 0 || pageX >= LevelPagesX(mip) || pageY < 0 || pageY >= LevelPagesY(mip)) return;
+
+    // Find the finest resident page covering the request
+    int top = header.mipCount - 1;
+    int level = mip;
+    while (level <= top) {
+        int shift = level - mip;
+        auto resident = residentPages.find(PageKey(pageX >> shift, pageY >> shift, level));
+        if (resident != residentPages.end()) {
+            slots[resident->second].lastUsedFrame = frameIndex;
+            break;
+        }
+        level++;
+    }
+
+    // Stream the missing levels in, coarsest first
+    for (int missing = level - 1; missing >= mip; missing--) {
+        int shift = missing - mip;
+        QueueLoad(PageKey(pageX >> shift, pageY >> shift, missing));
+    }
+}
+
+void VirtualTexture::QueueLoad(uint32_t page) {
+    if (pendingPages.count(page) > 0 || (int)pendingPages.size() >= maxPendingPages) return;
+
+    int mip = (int)(page >> 24);
+    int pageY = (int)((page >> 12) & 0xFFF);
+    int pageX = (int)(page & 0xFFF);
+    int index = levelOffsets[mip] + pageY*LevelPagesX(mip) + pageX;
+
+    pendingPages.insert(page);
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        loadQueue.push_back(TileRequest{ page, (int64_t)(sizeof(header) + (size_t)index*tileBytes) });
+    }
+    loaderCondition.notify_one();
+}
+
+void VirtualTexture::Update() {
+    if (!IsLoaded()) return;
+
+    UploadResults();
+
+    if (indirectionDirty) {
+        RebuildIndirection();
+    }
+
+    frameIndex++;
+}
+
+int VirtualTexture::AllocateSlot() {
+    // Prefer empty slots, then the least recently used page not needed this frame
+    int best = -1;
+    for (int slot = 0; slot < (int)slots.size(); slot++) {
+        const Slot& candidate = slots[slot];
+        if (candidate.page == EMPTY_PAGE) return slot;
+        if (candidate.pinned || candidate.lastUsedFrame == frameIndex) continue;
+        if (best == -1 || candidate.lastUsedFrame < slots[best].lastUsedFrame) best = slot;
+    }
+    return best;
+}
+
+void VirtualTexture::UploadTile(uint32_t page, const unsigned char* data, bool pinned) {
+    int slot = AllocateSlot();
+    if (slot < 0) return;
+
+    if (slots[slot].page != EMPTY_PAGE) {
+        residentPages.erase(slots[slot].page);
+    }
+
+    int slotX = slot % tilesPerSide;
+    int slotY = slot / tilesPerSide;
+    size_t layerBytes = (size_t)slotSize*slotSize*4;
+
+    for (int layer = 0; layer < header.layerCount; layer++) {
+        Rectangle region = {
+            (float)((layer*tilesPerSide + slotX)*slotSize),
+            (float)(slotY*slotSize),
+            (float)slotSize,
+            (float)slotSize
+        };
+        UpdateTextureRec(physicalTexture, region, data + layer*layerBytes);
+    }
+
+    slots[slot] = Slot{ page, frameIndex, pinned };
+    residentPages[page] = slot;
+    indirectionDirty = true;
+}
+
+void VirtualTexture::UploadResults() {
+    // Limit uploads to keep frame times stable
+    for (int upload = 0; upload < maxUploadsPerFrame; upload++) {
+        TileResult result;
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            if (loadResults.empty()) return;
+            result = std::move(loadResults.front());
+            loadResults.pop_front();
+        }
+
+        pendingPages.erase(result.page);
+        if (result.data.size() != tileBytes || residentPages.count(result.page) > 0) continue;
+
+        UploadTile(result.page, result.data.data(), false);
+    }
+}
+
+void VirtualTexture::RebuildIndirection() {
+    // Walk from the coarsest level down so missing pages inherit their parent
+    int top = header.mipCount - 1;
+    for (int mip = top; mip >= 0; mip--) {
+        int levelPagesX = LevelPagesX(mip);
+        int levelPagesY = LevelPagesY(mip);
+        unsigned char* level = &indirectionData[(size_t)levelOffsets[mip]*4];
+        bool levelChanged = false;
+
+        for (int pageY = 0; pageY < levelPagesY; pageY++) {
+            for (int pageX = 0; pageX < levelPagesX; pageX++) {
+                unsigned char texel[4] = { 0, 0, 0, 0 };
+
+                auto resident = residentPages.find(PageKey(pageX, pageY, mip));
+                if (resident != residentPages.end()) {
+                    texel[0] = (unsigned char)(resident->second % tilesPerSide);
+                    texel[1] = (unsigned char)(resident->second / tilesPerSide);
+                    texel[2] = (unsigned char)mip;
+                    texel[3] = 255;
+                } else if (mip < top) {
+                    int parentX = pageX*LevelPagesX(mip + 1)/levelPagesX;
+                    int parentY = pageY*LevelPagesY(mip + 1)/levelPagesY;
+                    memcpy(texel, &indirectionData[((size_t)levelOffsets[mip + 1] + parentY*LevelPagesX(mip + 1) + parentX)*4], 4);
+                }
+
+                unsigned char* current = &level[((size_t)pageY*levelPagesX + pageX)*4];
+                if (memcmp(current, texel, 4) != 0) {
+                    memcpy(current, texel, 4);
+                    levelChanged = true;
+                }
+            }
+        }
+
+        // Only re-upload the levels whose pages moved
+        if (levelChanged) {
+            glBindTexture(GL_TEXTURE_2D, indirectionTexture.id);
+            glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, levelPagesX, levelPagesY, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    }
+
+    indirectionDirty = false;
+}
+
+void VirtualTexture::LoaderLoop() {
+    while (true) {
+        TileRequest request;
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+            loaderCondition.wait(lock, [this] { return stopLoader || !loadQueue.empty(); });
+            if (stopLoader) return;
+            request = loadQueue.front();
+            loadQueue.pop_front();
+        }
+
+        // Only this thread reads the pack after Load
+        TileResult result;
+        result.page = request.page;
+        result.data.resize(tileBytes);
+        if (VT_FSEEK(packFile, request.offset, SEEK_SET) != 0 ||
+            fread(result.data.data(), 1, tileBytes, packFile) != tileBytes) {
+            result.data.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        loadResults.push_back(std::move(result));
+    }
+}
+
+Texture2D VirtualTexture::GetIndirectionTexture() const {
+    return indirectionTexture;
+}
+
+Texture2D VirtualTexture::GetPhysicalTexture() const {
+    return physicalTexture;
+}
+
+Vector4 VirtualTexture::GetPageParams() const {
+    return Vector4{ (float)header.pagesX, (float)header.pagesY, (float)header.tileSize, (float)header.mipCount };
+}
+
+Vector4 VirtualTexture::GetAtlasParams() const {
+    return Vector4{ (float)physicalTexture.width, (float)physicalTexture.height, (float)slotSize, (float)header.border };
+}
+
+Vector2 VirtualTexture::GetLayerParams() const {
+    return Vector2{ (float)header.layerCount, (float)(tilesPerSide*slotSize) };
+}
+
+int VirtualTexture::GetResidentPages() const {
+    return (int)residentPages.size();
+}
+
+int VirtualTexture::GetCacheCapacity() const {
+    return (int)slots.size();
+}
+
+int VirtualTexture::GetPendingPages() const {
+    return (int)pendingPages.size();
+}
+
+VirtualTextureFeedback::VirtualTextureFeedback()
+    : downscale(1),
+      mvpLoc(-1),
+      modelLoc(-1),
+      pageParamsLoc(-1),
+      textureIdLoc(-1),
+      mipBiasLoc(-1),
+      readbackIndex(0)
+{
+    target = { 0 };
+    shader = { 0 };
+    for (ReadbackBuffer& readback : readbacks) {
+        readback = ReadbackBuffer{ 0, nullptr, 0, 0, 0 };
+    }
+}
+
+VirtualTextureFeedback::~VirtualTextureFeedback() {
+    Unload();
+}
+
+void VirtualTextureFeedback::Load(int viewWidth, int viewHeight, int feedbackDownscale) {
+    downscale = std::max(1, feedbackDownscale);
+
+    shader = LoadShader("resources/shaders/basic.vs", "resources/shaders/vt_feedback.fs");
+    mvpLoc = GetShaderLocation(shader, "mvp2");
+    modelLoc = GetShaderLocation(shader, "matModel2");
+    pageParamsLoc = GetShaderLocation(shader, "vtPageParams");
+    textureIdLoc = GetShaderLocation(shader, "vtTextureId");
+    mipBiasLoc = GetShaderLocation(shader, "vtMipBias");
+
+    // Derivatives are larger in the smaller target, bias the mip back
+    float mipBias = -log2f((float)downscale);
+    SetShaderValue(shader, mipBiasLoc, &mipBias, SHADER_UNIFORM_FLOAT);
+
+    Resize(viewWidth, viewHeight);
+}
+
+void VirtualTextureFeedback::Unload() {
+    for (ReadbackBuffer& readback : readbacks) {
+        if (readback.fence != nullptr) glDeleteSync((GLsync)readback.fence);
+        if (readback.buffer > 0) glDeleteBuffers(1, &readback.buffer);
+        readback = ReadbackBuffer{ 0, nullptr, 0, 0, 0 };
+    }
+
+    if (target.id > 0) UnloadRenderTexture(target);
+    if (shader.id > 0) UnloadShader(shader);
+    target = { 0 };
+    shader = { 0 };
+}
+
+void VirtualTextureFeedback::Resize(int viewWidth, int viewHeight) {
+    int width = std::max(1, viewWidth/downscale);
+    int height = std::max(1, viewHeight/downscale);
+    if (target.id > 0 && target.texture.width == width && target.texture.height == height) return;
+
+    if (target.id > 0) UnloadRenderTexture(target);
+    target = LoadRenderTexture(width, height);
+}
+
+void VirtualTextureFeedback::Begin() {
+    BeginTextureMode(target);
+    ClearBackground(BLANK);
+
+    // Alpha carries the texture id, it must not be blended
+    rlDisableColorBlend();
+}
+
+void VirtualTextureFeedback::End() {
+    rlEnableColorBlend();
+    EndTextureMode();
+}
+
+Shader VirtualTextureFeedback::GetShader() const {
+    return shader;
+}
+
+void VirtualTextureFeedback::SetBody(const VirtualTexture& texture, int textureId, Matrix matModel, Matrix mvp) {
+    Vector4 pageParams = texture.GetPageParams();
+    SetShaderValue(shader, pageParamsLoc, &pageParams, SHADER_UNIFORM_VEC4);
+    SetShaderValue(shader, textureIdLoc, &textureId, SHADER_UNIFORM_INT);
+    SetShaderValueMatrix(shader, modelLoc, matModel);
+    SetShaderValueMatrix(shader, mvpLoc, mvp);
+}
+
+void VirtualTextureFeedback::Readback(VirtualTexture* const* textures, int count) {
+    // Queue a copy of this pass into a pixel pack buffer, glReadPixels
+    // returns right away and the GPU fills the buffer in the background
+    ReadbackBuffer& write = readbacks[readbackIndex];
+    size_t bytes = (size_t)target.texture.width*target.texture.height*4;
+    if (write.buffer == 0) glGenBuffers(1, &write.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, write.buffer);
+    if (write.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_READ);
+        write.capacity = bytes;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.id);
+    glReadPixels(0, 0, target.texture.width, target.texture.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    if (write.fence != nullptr) glDeleteSync((GLsync)write.fence);
+    write.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    write.width = target.texture.width;
+    write.height = target.texture.height;
+
+    // Map the copy queued by the previous pass, frames ago. If the GPU is
+    // still behind, skip it rather than wait, the next pass catches up.
+    readbackIndex = 1 - readbackIndex;
+    ReadbackBuffer& read = readbacks[readbackIndex];
+    if (read.fence != nullptr) {
+        GLenum status = glClientWaitSync((GLsync)read.fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            size_t readBytes = (size_t)read.width*read.height*4;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, read.buffer);
+            const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)readBytes, GL_MAP_READ_BIT);
+            if (pixels != nullptr) {
+                RequestPages(pixels, read.width*read.height, textures, count);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+        }
+        glDeleteSync((GLsync)read.fence);
+        read.fence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void VirtualTextureFeedback::RequestPages(const unsigned char* pixels, int pixelCount, VirtualTexture* const* textures, int count) {
+    const Color* colors = (const Color*)pixels;
+
+    Color previous = BLANK;
+    for (int i = 0; i < pixelCount; i++) {
+        Color pixel = colors[i];
+
+        // Neighbouring pixels mostly hit the same page
+        if (pixel.r == previous.r && pixel.g == previous.g && pixel.b == previous.b && pixel.a == previous.a) continue;
+        previous = pixel;
+
+        if (pixel.a == 0 || pixel.a > count) continue;
+        textures[pixel.a - 1]->RequestPage(pixel.r, pixel.g, pixel.b);
+    }
+}
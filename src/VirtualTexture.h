@@ -0,0 +1,163 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include "raylib.h"
+#include "VirtualTexturePack.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Sparse texture whose pages are streamed from a pack file into a
+// physical tile atlas. An indirection texture with one texel per page
+// (and one mip per page level) points the shader at the finest resident
+// page covering each texel.
+class VirtualTexture {
+public:
+    // Constructor/Destructor
+    VirtualTexture();
+    ~VirtualTexture();
+
+    // Open a pack file and create a cache of tilesPerSide^2 physical tiles
+    bool Load(const char* packPath, int tilesPerSide);
+    void Unload();
+    bool IsLoaded() const;
+
+    // Mark a page as needed this frame (usually from feedback)
+    void RequestPage(int pageX, int pageY, int mip);
+
+    // Upload loaded tiles, queue new loads and refresh the indirection
+    void Update();
+
+    // Textures and parameters sampled by basic.fs
+    Texture2D GetIndirectionTexture() const;
+    Texture2D GetPhysicalTexture() const;
+    Vector4 GetPageParams() const;      // Pages x/y at mip 0, tile size, mip count
+    Vector4 GetAtlasParams() const;     // Atlas width/height, slot size, border
+    Vector2 GetLayerParams() const;     // Layer count, layer stride in texels
+
+    // Cache statistics
+    int GetResidentPages() const;
+    int GetCacheCapacity() const;
+    int GetPendingPages() const;
+
+private:
+    struct Slot {
+        uint32_t page;          // Page key, or EMPTY_PAGE
+        unsigned int lastUsedFrame;
+        bool pinned;            // Coarsest page is never evicted
+    };
+
+    struct TileRequest {
+        uint32_t page;
+        int64_t offset;
+    };
+
+    struct TileResult {
+        uint32_t page;
+        std::vector<unsigned char> data;    // All layers of the tile
+    };
+
+    VirtualTexturePackHeader header;
+    int tilesPerSide;
+    int slotSize;
+    size_t tileBytes;
+    unsigned int frameIndex;
+    int maxUploadsPerFrame;
+    int maxPendingPages;
+
+    // Page table and physical cache
+    std::vector<int> levelOffsets;      // First page index of each mip
+    std::vector<Slot> slots;
+    std::unordered_map<uint32_t, int> residentPages;
+    std::unordered_set<uint32_t> pendingPages;
+    bool indirectionDirty;
+
+    // GPU resources
+    Texture2D indirectionTexture;
+    Texture2D physicalTexture;
+    std::vector<unsigned char> indirectionData;
+
+    // Loader thread state
+    FILE* packFile;
+    std::thread loaderThread;
+    std::mutex loaderMutex;
+    std::condition_variable loaderCondition;
+    std::deque<TileRequest> loadQueue;
+    std::deque<TileResult> loadResults;
+    bool stopLoader;
+
+    // Helper methods
+    int LevelPagesX(int mip) const;
+    int LevelPagesY(int mip) const;
+    static uint32_t PageKey(int pageX, int pageY, int mip);
+    void QueueLoad(uint32_t page);
+    int AllocateSlot();
+    void UploadTile(uint32_t page, const unsigned char* data, bool pinned);
+    void UploadResults();
+    void RebuildIndirection();
+    void LoaderLoop();
+};
+
+// Low resolution pass that records which virtual pages are visible. Bodies
+// are drawn with the feedback shader; every pixel stores page x, page y,
+// mip and the id of the virtual texture it belongs to.
+class VirtualTextureFeedback {
+public:
+    // Constructor/Destructor
+    VirtualTextureFeedback();
+    ~VirtualTextureFeedback();
+
+    // Load the feedback shader and target at a fraction of the view size
+    void Load(int viewWidth, int viewHeight, int downscale);
+    void Unload();
+    void Resize(int viewWidth, int viewHeight);
+
+    // Render into the feedback target
+    void Begin();
+    void End();
+
+    // Set uniforms for the next body drawn with the feedback shader
+    Shader GetShader() const;
+    void SetBody(const VirtualTexture& texture, int textureId, Matrix matModel, Matrix mvp);
+
+    // Start reading the target back, then request pages (id = index + 1)
+    // seen by the previous pass once its copy has finished
+    void Readback(VirtualTexture* const* textures, int count);
+
+private:
+    // Pixel pack buffer a pass is copied into without stalling
+    struct ReadbackBuffer {
+        unsigned int buffer;
+        void* fence;            // GLsync signalled when the copy is done
+        int width;
+        int height;
+        size_t capacity;
+    };
+
+    RenderTexture2D target;
+    Shader shader;
+    int downscale;
+
+    // Shader locations
+    int mvpLoc;
+    int modelLoc;
+    int pageParamsLoc;
+    int textureIdLoc;
+    int mipBiasLoc;
+
+    // Two buffers in rotation, one is written while the other is read
+    ReadbackBuffer readbacks[2];
+    int readbackIndex;
+
+    // Helper methods
+    void RequestPages(const unsigned char* pixels, int pixelCount, VirtualTexture* const* textures, int count);
+};
+
+#endif // VIRTUAL_TEXTURE_H
@@ -0,0 +1,57 @@
+// Headless virtual texture pack baker, usable without a window or GPU.
+// Without arguments builds the surface packs the app loads.
+// Usage: VirtualTextureBake [output path tile size border layer paths...]
+#include "VirtualTexturePack.h"
+#include "raylib.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+struct PackJob {
+    const char* outputPath;
+    const char* const* layerPaths;
+    int layerCount;
+    int tileSize;
+    int border;
+};
+
+static bool Bake(const PackJob& job) {
+    printf("Baking %s from %i layers, %i texel tiles\n", job.outputPath, job.layerCount, job.tileSize);
+    auto start = std::chrono::steady_clock::now();
+
+    if (!BuildVirtualTexturePack(job.outputPath, job.layerPaths, job.layerCount, job.tileSize, job.border)) {
+        fprintf(stderr, "Failed to write %s\n", job.outputPath);
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Wrote %s in %.2f s\n", job.outputPath, seconds);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    SetTraceLogLevel(LOG_WARNING);
+
+    if (argc > 1) {
+        if (argc < 5) {
+            fprintf(stderr, "Usage: %s [output path tile size border layer paths...]\n", argv[0]);
+            return 1;
+        }
+        PackJob job = { argv[1], argv + 4, argc - 4, atoi(argv[2]), atoi(argv[3]) };
+        return Bake(job) ? 0 : 1;
+    }
+
+    // Diffuse and normal layers of the bodies with virtual textures
+    static const char* const earthLayers[] = { "resources/images/2k_earth_daymap.png", "resources/images/2k_earth_normal_map.png" };
+    static const char* const moonLayers[] = { "resources/images/Moon.Diffuse.png", "resources/images/Moon.Normal.png" };
+    const PackJob jobs[] = {
+        { "resources/images/earth.vtp", earthLayers, 2, 128, 1 },
+        { "resources/images/moon.vtp", moonLayers, 2, 128, 1 },
+    };
+
+    for (const PackJob& job : jobs) {
+        if (!Bake(job)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "VirtualTexturePack.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int NextPowerOfTwo(int value) {
+    int result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+static int MipCountForPages(int pagesX, int pagesY) {
+    int largest = std::max(pagesX, pagesY);
+    int mipCount = 1;
+    while ((largest >> mipCount) > 0) mipCount++;
+    return mipCount;
+}
+
+// Copy one tile plus border out of a level image, wrapping horizontally
+// (equirectangular maps are periodic in longitude) and clamping vertically
+static void CopyTile(const Image& level, int tileX, int tileY, int tileSize, int border, unsigned char* dest) {
+    const unsigned char* pixels = (const unsigned char*)level.data;
+    int slotSize = tileSize + 2*border;
+
+    for (int y = 0; y < slotSize; y++) {
+        int sourceY = tileY*tileSize + y - border;
+        sourceY = (sourceY < 0) ? 0 : ((sourceY >= level.height) ? level.height - 1 : sourceY);
+
+        for (int x = 0; x < slotSize; x++) {
+            int sourceX = (tileX*tileSize + x - border + level.width) % level.width;
+            memcpy(dest + (y*slotSize + x)*4, pixels + ((size_t)sourceY*level.width + sourceX)*4, 4);
+        }
+    }
+}
+
+static bool WriteAt(FILE* file, int64_t offset, const void* data, size_t size) {
+    return VT_FSEEK(file, offset, SEEK_SET) == 0 && fwrite(data, 1, size, file) == size;
+}
+
+int64_t GetVirtualTexturePackBytes(const VirtualTexturePackHeader& header) {
+    if (memcmp(header.magic, "RSVT", 4) != 0 || header.version != VT_PACK_VERSION) return 0;
+    if (header.layerCount < 1 || header.layerCount > VT_MAX_LAYERS) return 0;
+    if (header.tileSize < 1 || header.border < 0 || header.border > header.tileSize) return 0;
+    if (header.pagesX < 1 || header.pagesX > VT_MAX_PAGES || header.pagesY < 1 || header.pagesY > VT_MAX_PAGES) return 0;
+    if (header.mipCount != MipCountForPages(header.pagesX, header.pagesY)) return 0;
+
+    int64_t pageCount = 0;
+    for (int mip = 0; mip < header.mipCount; mip++) {
+        pageCount += (int64_t)std::max(header.pagesX >> mip, 1)*std::max(header.pagesY >> mip, 1);
+    }
+    int64_t slotSize = header.tileSize + 2*header.border;
+    return (int64_t)sizeof(header) + pageCount*header.layerCount*slotSize*slotSize*4;
+}
+
+bool BuildVirtualTexturePack(const char* outputPath, const char* const* layerPaths, int layerCount, int tileSize, int border) {
+    if (layerCount < 1 || layerCount > VT_MAX_LAYERS || tileSize < 1 || border < 0 || border > tileSize) return false;
+
+    // The first layer decides the page grid
+    Image image = LoadImage(layerPaths[0]);
+    if (image.data == nullptr) {
+        TraceLog(LOG_WARNING, "VT: Failed to load pack layer %s", layerPaths[0]);
+        return false;
+    }
+
+    VirtualTexturePackHeader header;
+    memcpy(header.magic, "RSVT", 4);
+    header.version = VT_PACK_VERSION;
+    header.tileSize = tileSize;
+    header.border = border;
+    header.pagesX = NextPowerOfTwo((image.width + tileSize - 1)/tileSize);
+    header.pagesY = NextPowerOfTwo((image.height + tileSize - 1)/tileSize);
+    header.mipCount = MipCountForPages(header.pagesX, header.pagesY);
+    header.layerCount = layerCount;
+
+    if (header.pagesX > VT_MAX_PAGES || header.pagesY > VT_MAX_PAGES) {
+        TraceLog(LOG_WARNING, "VT: %s needs %ix%i pages, more than %i per side", layerPaths[0], header.pagesX, header.pagesY, VT_MAX_PAGES);
+        UnloadImage(image);
+        return false;
+    }
+
+    // Write next to the output and rename at the end, so an interrupted
+    // build never leaves a truncated pack behind
+    std::string tempPath = std::string(outputPath) + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        TraceLog(LOG_WARNING, "VT: Failed to create pack %s", tempPath.c_str());
+        UnloadImage(image);
+        return false;
+    }
+    bool success = WriteAt(file, 0, &header, sizeof(header));
+
+    int slotSize = tileSize + 2*border;
+    size_t slotBytes = (size_t)slotSize*slotSize*4;
+    std::vector<unsigned char> tile(slotBytes);
+
+    // One layer in memory at a time, each one is written into its place
+    // between the other layers' tiles
+    for (int layer = 0; layer < layerCount && success; layer++) {
+        if (layer > 0) {
+            image = LoadImage(layerPaths[layer]);
+            if (image.data == nullptr) {
+                TraceLog(LOG_WARNING, "VT: Failed to load pack layer %s", layerPaths[layer]);
+                success = false;
+                break;
+            }
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+        int64_t pageIndex = 0;
+        for (int mip = 0; mip < header.mipCount && success; mip++) {
+            int levelPagesX = std::max(header.pagesX >> mip, 1);
+            int levelPagesY = std::max(header.pagesY >> mip, 1);
+
+            // Each level is resampled from the previous one
+            ImageResize(&image, levelPagesX*tileSize, levelPagesY*tileSize);
+
+            for (int tileY = 0; tileY < levelPagesY && success; tileY++) {
+                for (int tileX = 0; tileX < levelPagesX && success; tileX++) {
+                    CopyTile(image, tileX, tileY, tileSize, border, tile.data());
+                    int64_t offset = (int64_t)sizeof(header) + (pageIndex*layerCount + layer)*(int64_t)slotBytes;
+                    success = WriteAt(file, offset, tile.data(), slotBytes);
+                    pageIndex++;
+                }
+            }
+        }
+        UnloadImage(image);
+    }
+
+    // Buffered writes can still fail on close (e.g. a full disk)
+    if (fclose(file) != 0) success = false;
+
+#if defined(_WIN32)
+    // rename does not replace an existing file on Windows
+    if (success) remove(outputPath);
+#endif
+    if (success && rename(tempPath.c_str(), outputPath) != 0) success = false;
+
+    if (!success) {
+        TraceLog(LOG_WARNING, "VT: Failed to write pack %s", outputPath);
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "VT: Built pack %s (%ix%i pages, %i mips)", outputPath, header.pagesX, header.pagesY, header.mipCount);
+    return true;
+}
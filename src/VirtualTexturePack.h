@@ -0,0 +1,48 @@
+#ifndef VIRTUAL_TEXTURE_PACK_H
+#define VIRTUAL_TEXTURE_PACK_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Maximum number of images (diffuse, normal, ...) sharing one page table
+#define VT_MAX_LAYERS 4
+
+// Page coordinates are packed into 12 bits each
+#define VT_MAX_PAGES 4096
+
+#define VT_PACK_VERSION 1
+
+// 64-bit file offsets, pack files for 16k+ surfaces exceed 2GB
+#if defined(_WIN32)
+    #define VT_FSEEK _fseeki64
+    #define VT_FTELL _ftelli64
+#else
+    #define VT_FSEEK fseeko
+    #define VT_FTELL ftello
+#endif
+
+// Header of a packed tile file. Tiles follow the header ordered by mip,
+// then row, then column, with the layers of each tile stored back to back.
+// Every tile is RGBA8 and includes a border of neighbouring texels.
+struct VirtualTexturePackHeader {
+    char magic[4];      // "RSVT"
+    int version;
+    int tileSize;       // Tile payload size in texels
+    int border;         // Border texels on each side of a tile
+    int pagesX;         // Pages across at mip 0 (power of two)
+    int pagesY;         // Pages down at mip 0 (power of two)
+    int mipCount;       // Levels down to a single page
+    int layerCount;
+};
+
+// Check the header fields and return the size the whole pack must have,
+// or 0 if the header is not a pack this version can read
+int64_t GetVirtualTexturePackBytes(const VirtualTexturePackHeader& header);
+
+// Build a pack file from equirectangular images that share one mapping.
+// Layers are tiled one at a time into a temporary file that replaces
+// outputPath only once every write succeeded. Only uses CPU image
+// functions, run it offline with the VirtualTextureBake tool.
+bool BuildVirtualTexturePack(const char* outputPath, const char* const* layerPaths, int layerCount, int tileSize, int border);
+
+#endif // VIRTUAL_TEXTURE_PACK_H
@@ -3,10 +3,34 @@
 #include "raymath.h"
 #include "CelestialBody.h"
 #include "Tools.h"
+#include "OrbitTrails.h"
+#include "JobSystem.h"
+#include "TelemetryPublisher.h"
+#include "DynamicBVH.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "ClusteredLights.h"
+#include <cstdio>
+#include <cstdlib>
 // Add ImGui headers
 #include "imgui.h"
 #include "rlImGui.h"
 
+// ImGui allocator that reports to the frame allocation counters
+static void* ImGuiAllocate(size_t size, void* userData)
+{
+    (void)userData;
+    RecordAllocation(size);
+    return malloc(size);
+}
+
+static void ImGuiFree(void* memory, void* userData)
+{
+    (void)userData;
+    RecordFree(memory);
+    free(memory);
+}
+
 int main() 
 {
     // Initialize window
@@ -24,7 +48,8 @@ int main()
     // Create render texture for the camera view
     RenderTexture2D cameraRenderTexture = LoadRenderTexture(renderTextureWidth, renderTextureHeight);
     
-    // Initialize ImGui
+    // Initialize ImGui, its heap use is counted with the rest of the frame
+    ImGui::SetAllocatorFunctions(ImGuiAllocate, ImGuiFree, nullptr);
     rlImGuiSetup(true);
     
     // Variables to track current window size
@@ -41,6 +66,7 @@ int main()
     
     // Define the light position (in world space)
     Vector3 lightPos = { 5.0f, 3.0f, 0.0f };
+    float lightRadius = 0.5f; // Light disk radius, controls eclipse penumbra width
     
     // Simulation pause state
     bool simulationPaused = false;
@@ -51,12 +77,44 @@ int main()
     // Create pause button
     Rectangle pauseButton = { screenWidth - 110.0f, 10.0f, 100.0f, 30.0f };
     
+    // Texture residency manager keeps body textures within a VRAM budget
+    TextureResidency textureResidency(64*1024*1024);
+
+    // Surface diffuse and normal maps are streamed as virtual textures from
+    // tile packs baked offline by VirtualTextureBake
+    VirtualTexture earthSurface;
+    VirtualTexture moonSurface;
+    bool earthSurfaceLoaded = earthSurface.Load("resources/images/earth.vtp", 24);
+    bool moonSurfaceLoaded = moonSurface.Load("resources/images/moon.vtp", 16);
+    if (!earthSurfaceLoaded || !moonSurfaceLoaded) {
+        TraceLog(LOG_WARNING, "VT: Surface packs missing, run VirtualTextureBake from the build directory");
+    }
+    VirtualTexture* virtualTextures[] = { &earthSurface, &moonSurface }; // Feedback ids 1 and 2
+
+    // Feedback pass runs at a quarter of the view resolution every few frames
+    VirtualTextureFeedback virtualTextureFeedback;
+    virtualTextureFeedback.Load(renderTextureWidth, renderTextureHeight, 4);
+    const int feedbackInterval = 4;
+    int frameCounter = 0;
+
+    // Earth's atmosphere, lookup tables are baked once and cached on disk
+    Atmosphere atmosphere;
+    atmosphere.Load("resources/atmosphere.lut", GetEarthAtmosphereParameters());
+
+    // Local point lights, binned into view-space clusters every frame
+    ClusteredLights clusteredLights;
+    clusteredLights.Load();
+
     // Create Earth celestial body
     CelestialBody earth("Earth", 1.0f, 10.0f); // Name, radius, rotation speed
+    earth.SetTextureResidency(&textureResidency);
+    earth.SetVirtualTexture(&earthSurface);
+    earth.SetAtmosphere(&atmosphere);
+    earth.SetClusteredLights(&clusteredLights);
     earth.Initialize(
-        "resources/model/sphere.glb",
-        "resources/images/2k_earth_daymap.png",
-        "resources/images/2k_earth_normal_map.png",
+        nullptr, // Built-in compact sphere
+        nullptr, // Diffuse and normal come from the virtual texture
+        nullptr,
         "resources/images/2k_earth_specular_map.png",
         "resources/images/2k_earth_nightmap.png",
         "resources/images/2k_earth_clouds.png"
@@ -64,13 +122,129 @@ int main()
     
     // Create Moon celestial body
     CelestialBody moon("Moon", 0.27f, 6.0f); // Name, radius (27% of Earth), rotation speed
+    moon.SetTextureResidency(&textureResidency);
+    moon.SetVirtualTexture(&moonSurface);
+    moon.SetClusteredLights(&clusteredLights);
     moon.Initialize(
-        "resources/model/sphere.glb",
-       "resources/images/Moon.Diffuse.png",
-        "resources/images/Moon.Normal.png"
+        nullptr, // Built-in compact sphere
+        nullptr, // Diffuse and normal come from the virtual texture
+        nullptr
     );
     moon.SetScale(0.27f); // Set moon scale to 27% of Earth's size
     moon.SetOrbit(&earth, 4.5f, 5.0f, 5.0f); // Parent, distance, speed, tilt
+
+    // Orbit trails for every body that orbits a parent
+    CelestialBody* bodies[] = { &earth, &moon };
+    const int bodyCount = sizeof(bodies)/sizeof(bodies[0]);
+    OrbitTrails orbitTrails;
+    orbitTrails.Load(64, 512); // Max trails, points per trail
+    int bodyTrails[bodyCount];
+    for (int i = 0; i < bodyCount; i++) {
+        bodyTrails[i] = bodies[i]->GetOrbitSystem().HasParent() ? orbitTrails.AddTrail() : -1;
+    }
+    bool showOrbitTrails = true;
+    float simulationTime = 0.0f;
+
+    // Demo lights: beacons circling the Earth on random inclined orbits
+    // just above the surface (orbit radius, inclination, phase, speed)
+    std::vector<PointLight> localLights(MAX_CLUSTERED_LIGHTS);
+    std::vector<Vector4> localLightOrbits(MAX_CLUSTERED_LIGHTS);
+    const Vector3 localLightPalette[] = { { 1.0f, 0.6f, 0.25f }, { 0.6f, 0.8f, 1.0f }, { 1.0f, 1.0f, 0.9f }, { 0.4f, 1.0f, 0.6f } };
+    SetRandomSeed(7);
+    for (int i = 0; i < MAX_CLUSTERED_LIGHTS; i++) {
+        localLightOrbits[i] = Vector4{ 1.02f + GetRandomValue(0, 100)*0.004f, GetRandomValue(-90, 90)*DEG2RAD,
+                                       GetRandomValue(0, 359)*DEG2RAD, GetRandomValue(5, 30)*0.01f };
+        localLights[i].color = localLightPalette[i % 4];
+    }
+    bool localLightsEnabled = true;
+    int localLightCount = 128;
+    float localLightRange = 0.3f;
+    float localLightIntensity = 1.0f;
+    bool showLightMarkers = false;
+
+    // Per-frame CPU work runs on a work-stealing job system, the main
+    // thread joins in while waiting and then submits the draws to GL
+    JobSystem jobSystem;
+    int hardwareThreads = (int)std::thread::hardware_concurrency();
+    if (hardwareThreads < 1) hardwareThreads = 1;
+    jobSystem.Start(hardwareThreads - 1);
+
+    // Frame graph: bodies update after their orbit parent, then transforms
+    // and visibility are prepared in parallel over body ranges
+    float deltaTime = 0.0f;
+    Matrix viewProjection = MatrixIdentity();
+    float viewAspect = 1.0f;
+    TaskGraph frameGraph;
+    TaskGraph::TaskId updateTasks[bodyCount];
+    for (int i = 0; i < bodyCount; i++) {
+        updateTasks[i] = frameGraph.Add("Update body", [&, i]() {
+            if (!simulationPaused) bodies[i]->Update(deltaTime);
+        });
+    }
+    for (int i = 0; i < bodyCount; i++) {
+        CelestialBody* parent = bodies[i]->GetOrbitSystem().GetOrbitParent();
+        for (int j = 0; j < bodyCount; j++) {
+            if (bodies[j] == parent) frameGraph.Depend(updateTasks[i], updateTasks[j]);
+        }
+    }
+    TaskGraph::TaskId prepareTask = frameGraph.Add("Prepare draws", [&]() {
+        jobSystem.ParallelFor(0, bodyCount, 64, [&](int first, int last) {
+            for (int i = first; i < last; i++) {
+                bodies[i]->PrepareDraw(viewProjection);
+            }
+        });
+    });
+    for (int i = 0; i < bodyCount; i++) {
+        frameGraph.Depend(prepareTask, updateTasks[i]);
+    }
+
+    // Local lights follow the Earth, then are binned per depth slice
+    TaskGraph::TaskId lightTask = frameGraph.Add("Cluster lights", [&]() {
+        int count = localLightsEnabled ? localLightCount : 0;
+        Vector3 center = earth.GetPosition();
+        for (int i = 0; i < count; i++) {
+            const Vector4& orbit = localLightOrbits[i];
+            float angle = orbit.z + orbit.w*simulationTime;
+            Vector3 offset = { cosf(angle), sinf(angle)*sinf(orbit.y), sinf(angle)*cosf(orbit.y) };
+            localLights[i].position = Vector3Add(center, Vector3Scale(offset, orbit.x*earth.GetRadius()));
+            localLights[i].range = localLightRange;
+            localLights[i].intensity = localLightIntensity;
+        }
+        clusteredLights.SetLights(localLights.data(), count);
+        clusteredLights.Build(camera, viewAspect, jobSystem);
+    });
+    for (int i = 0; i < bodyCount; i++) {
+        frameGraph.Depend(lightTask, updateTasks[i]);
+    }
+
+    // Transient per-frame data lives in the frame arena, reset after
+    // EndDrawing. Steady-state frames should not touch the heap at all.
+    FrameArena frameArena(256*1024);
+    FrameAllocationTracker frameAllocations(120);
+
+    // Live body state for external tools, published into shared memory
+    TelemetryPublisher telemetry;
+    if (!telemetry.Open("renderstream_telemetry")) {
+        TraceLog(LOG_WARNING, "TELEMETRY: Failed to create shared memory region");
+    }
+    bool publishTelemetry = true;
+    uint64_t simulationTick = 0;
+
+    // Bounding sphere hierarchy for picking and spatial queries
+    DynamicBVH bodyTree;
+    int bodyProxies[bodyCount];
+    for (int i = 0; i < bodyCount; i++) {
+        bodyProxies[i] = bodyTree.CreateProxy(bodies[i]->GetPosition(), bodies[i]->GetRadius(), i);
+    }
+    int selectedBody = -1;
+    float queryRadius = 5.0f;
+    float closeApproachDistance = 3.0f;
+    std::vector<int> queryResults;
+    std::vector<std::pair<int, int>> closeApproaches;
+
+    // Scaling test for the job system panel
+    int scalingTestItems = 20000;
+    std::vector<JobScalingResult> scalingResults;
     
 
     SetTargetFPS(60);  // Set our game to run at 60 frames-per-second
@@ -111,6 +285,7 @@ int main()
             // Update current window dimensions
             currentWidth = GetScreenWidth();
             currentHeight = GetScreenHeight();
+            frameAllocations.ResetSteadyState();
             
             // Update UI element positions based on new window size
             pauseButton.x = currentWidth - 110.0f;
@@ -121,21 +296,98 @@ int main()
         
         UpdateCamera(&camera, CAMERA_ORBITAL); // Update camera based on user input
         
-        // Update celestial bodies
-        float deltaTime = GetFrameTime();
+        // Update celestial bodies and prepare their draws on the job system
+        deltaTime = GetFrameTime();
+        viewProjection = GetViewProjectionMatrix(camera);
+        viewAspect = (float)GetScreenWidth()/(float)GetScreenHeight();
+        jobSystem.ResetStatistics();
+        frameGraph.Run(jobSystem);
+        clusteredLights.Upload();
         if (!simulationPaused) {
-            earth.Update(deltaTime);
-            moon.Update(deltaTime);
+            simulationTime += deltaTime;
+            simulationTick++;
+        }
+
+        // Refit the hierarchy, bodies are only reinserted once they leave their fat box
+        bodyTree.ResetReinsertCount();
+        for (int i = 0; i < bodyCount; i++) {
+            bodyTree.MoveProxy(bodyProxies[i], bodies[i]->GetPosition(), bodies[i]->GetRadius());
+        }
+
+        // Snapshot of this tick, written in place into the shared ring
+        if (publishTelemetry && telemetry.IsOpen()) {
+            TelemetryBodyState* states = telemetry.BeginSnapshot(simulationTick, simulationTime);
+            int stateCount = (bodyCount < TELEMETRY_MAX_BODIES) ? bodyCount : TELEMETRY_MAX_BODIES;
+            for (int i = 0; i < stateCount; i++) {
+                Vector3 position = bodies[i]->GetPosition();
+                Quaternion orientation = bodies[i]->GetOrientation();
+                states[i].id = (uint32_t)i;
+                snprintf(states[i].name, TELEMETRY_NAME_LENGTH, "%s", bodies[i]->GetName().c_str());
+                states[i].position[0] = position.x;
+                states[i].position[1] = position.y;
+                states[i].position[2] = position.z;
+                states[i].orientation[0] = orientation.x;
+                states[i].orientation[1] = orientation.y;
+                states[i].orientation[2] = orientation.z;
+                states[i].orientation[3] = orientation.w;
+                states[i].radius = bodies[i]->GetRadius();
+            }
+            telemetry.EndSnapshot(stateCount);
+        }
+
+        // Visible bodies in submission order
+        CelestialBody** drawList = frameArena.AllocateArray<CelestialBody*>(bodyCount);
+        int drawCount = 0;
+        for (int i = 0; i < bodyCount; i++) {
+            if (bodies[i]->IsVisible()) drawList[drawCount++] = bodies[i];
+        }
+
+        // Extend orbit trails, points are only kept where the path bends
+        for (int i = 0; i < bodyCount; i++) {
+            orbitTrails.Sample(bodyTrails[i], bodies[i]->GetPosition(), simulationTime);
         }
         
         // Update shader values with current camera and light positions
         earth.UpdateShaderValues(camera, lightPos);
         moon.UpdateShaderValues(camera, lightPos);
+
+        // Bodies eclipse each other analytically in the shader
+        Vector4 shadowOccluders[bodyCount];
+        for (int i = 0; i < bodyCount; i++) {
+            Vector3 center = bodies[i]->GetPosition();
+            shadowOccluders[i] = Vector4{ center.x, center.y, center.z, bodies[i]->GetRadius() };
+        }
+        for (int i = 0; i < bodyCount; i++) {
+            bodies[i]->UpdateShadowOccluders(shadowOccluders, bodyCount, lightRadius);
+        }
+
+        // Request texture mips from projected size and stream them in. Only
+        // visible bodies touch their textures, so hidden ones go cold.
+        for (int i = 0; i < drawCount; i++) {
+            drawList[i]->UpdateTextureResidency(camera, renderTextureHeight);
+        }
+        textureResidency.Update();
         
         // Draw
         BeginDrawing();
         
             ClearBackground(GRAY);
+
+            // Find visible virtual texture pages and stream them in
+            if (frameCounter % feedbackInterval == 0)
+            {
+                virtualTextureFeedback.Resize(renderTextureWidth, renderTextureHeight);
+                virtualTextureFeedback.Begin();
+                    BeginMode3D(camera);
+                        earth.DrawVirtualTextureFeedback(camera, virtualTextureFeedback, 1);
+                        moon.DrawVirtualTextureFeedback(camera, virtualTextureFeedback, 2);
+                    EndMode3D();
+                virtualTextureFeedback.End();
+                virtualTextureFeedback.Readback(virtualTextures, 2);
+            }
+            earthSurface.Update();
+            moonSurface.Update();
+            frameCounter++;
             
             // Only render the 3D scene to the render texture
             BeginTextureMode(cameraRenderTexture);
@@ -147,8 +399,21 @@ int main()
                     rlEnableBackfaceCulling();
                     rlEnableDepthMask();
 
-                    earth.Draw(camera);
-                    moon.Draw(camera);            
+                    for (int i = 0; i < drawCount; i++) {
+                        drawList[i]->Draw();
+                    }
+                    atmosphere.Draw(camera, earth.GetPosition(), earth.GetRadius(), lightPos);
+
+                    if (showLightMarkers) {
+                        for (int i = 0; i < clusteredLights.GetLightCount(); i++) {
+                            const PointLight& light = localLights[i];
+                            DrawCube(light.position, 0.02f, 0.02f, 0.02f, ColorFromNormalized(Vector4{ light.color.x, light.color.y, light.color.z, 1.0f }));
+                        }
+                    }
+
+                    if (showOrbitTrails) {
+                        orbitTrails.Draw(camera, simulationTime);
+                    }
                 EndMode3D();
             EndTextureMode();
             
@@ -183,6 +448,22 @@ int main()
                             ImVec2(contentSize.x, contentSize.y), 
                             ImVec2(0, 1),  // UV0: flip vertically
                             ImVec2(1, 0)); // UV1: flip vertically
+
+                // Pick the body under the cursor. Bodies are projected with the
+                // window aspect (see GetViewProjectionMatrix), so the click is
+                // mapped to window coordinates before building the ray.
+                if (ImGui::IsItemClicked(ImGuiMouseButton_Left))
+                {
+                    ImVec2 imageMin = ImGui::GetItemRectMin();
+                    ImVec2 imageSize = ImGui::GetItemRectSize();
+                    ImVec2 mouse = ImGui::GetMousePos();
+                    Vector2 screenPosition = {
+                        (mouse.x - imageMin.x)/imageSize.x*GetScreenWidth(),
+                        (mouse.y - imageMin.y)/imageSize.y*GetScreenHeight()
+                    };
+                    Ray ray = GetScreenToWorldRayEx(screenPosition, camera, GetScreenWidth(), GetScreenHeight());
+                    selectedBody = bodyTree.Raycast(ray, 1000.0f, nullptr);
+                }
             }
             ImGui::End();
             
@@ -190,6 +471,7 @@ int main()
             if (ImGui::Begin("Simulation Controls"))
             {
                 ImGui::Checkbox("Pause Simulation", &simulationPaused);
+                ImGui::SliderFloat("Light Radius", &lightRadius, 0.01f, 2.0f);
                 
                 ImGui::Separator();
                 
@@ -200,6 +482,12 @@ int main()
                     {
                         earth.SetRotationSpeed(earthRotationSpeed);
                     }
+
+                    float atmosphereExposure = atmosphere.GetExposure();
+                    if (ImGui::SliderFloat("Atmosphere Exposure", &atmosphereExposure, 1.0f, 100.0f))
+                    {
+                        atmosphere.SetExposure(atmosphereExposure);
+                    }
                     
                     ImGui::TreePop();
                 }
@@ -221,6 +509,63 @@ int main()
                     ImGui::TreePop();
                 }
                 
+                if (ImGui::TreeNode("Orbit Trails"))
+                {
+                    ImGui::Checkbox("Show Trails", &showOrbitTrails);
+
+                    float maxAngle = orbitTrails.GetMaxAngle();
+                    if (ImGui::SliderFloat("Max Bend (deg)", &maxAngle, 0.25f, 15.0f))
+                    {
+                        orbitTrails.SetMaxAngle(maxAngle);
+                    }
+
+                    float fadeTime = orbitTrails.GetFadeTime();
+                    if (ImGui::SliderFloat("Fade Time (s)", &fadeTime, 1.0f, 120.0f))
+                    {
+                        orbitTrails.SetFadeTime(fadeTime);
+                    }
+
+                    ImGui::Text("Points: %i", orbitTrails.GetPointCount());
+                    ImGui::Text("Upload: %i bytes, %i draw call(s)", orbitTrails.GetUploadBytes(), orbitTrails.GetDrawCalls());
+
+                    ImGui::TreePop();
+                }
+
+                if (ImGui::TreeNode("Local Lights"))
+                {
+                    ImGui::Checkbox("Enable", &localLightsEnabled);
+                    ImGui::SliderInt("Count", &localLightCount, 1, MAX_CLUSTERED_LIGHTS);
+                    ImGui::SliderFloat("Range", &localLightRange, 0.05f, 2.0f);
+                    ImGui::SliderFloat("Intensity", &localLightIntensity, 0.0f, 4.0f);
+                    ImGui::Checkbox("Show Markers", &showLightMarkers);
+
+                    ImGui::Text("Clusters: %ix%ix%i", CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+                    ImGui::Text("Light indices: %i, max %i per cluster", clusteredLights.GetIndexCount(), clusteredLights.GetMaxClusterLights());
+                    if (clusteredLights.GetDroppedCount() > 0)
+                    {
+                        ImGui::Text("Dropped from full clusters: %i", clusteredLights.GetDroppedCount());
+                    }
+                    ImGui::Text("Binning: %.3f ms", clusteredLights.GetBuildMilliseconds());
+
+                    ImGui::TreePop();
+                }
+
+                if (ImGui::TreeNode("Telemetry"))
+                {
+                    ImGui::Checkbox("Publish", &publishTelemetry);
+                    if (telemetry.IsOpen())
+                    {
+                        ImGui::Text("Shared memory: %s", telemetry.GetName());
+                        ImGui::Text("Snapshots: %llu", (unsigned long long)telemetry.GetPublishedCount());
+                    }
+                    else
+                    {
+                        ImGui::Text("Shared memory unavailable");
+                    }
+
+                    ImGui::TreePop();
+                }
+
                 ImGui::Separator();
                 
                 if (ImGui::Button("Reset Camera"))
@@ -230,13 +575,219 @@ int main()
                 }
             }
             ImGui::End();
+
+            // Texture memory statistics
+            if (ImGui::Begin("Texture Memory"))
+            {
+                const float megabyte = 1024.0f*1024.0f;
+                float budgetMB = textureResidency.GetBudget()/megabyte;
+                if (ImGui::SliderFloat("Budget (MB)", &budgetMB, 4.0f, 1024.0f, "%.0f"))
+                {
+                    textureResidency.SetBudget((size_t)(budgetMB*megabyte));
+                }
+
+                int coldFrames = (int)textureResidency.GetColdFrames();
+                if (ImGui::SliderInt("Cold After (frames)", &coldFrames, 1, 600))
+                {
+                    textureResidency.SetColdFrames((unsigned int)coldFrames);
+                }
+
+                float residentMB = textureResidency.GetResidentBytes()/megabyte;
+                ImGui::ProgressBar(residentMB/budgetMB, ImVec2(-1, 0), TextFormat("%.1f / %.0f MB", residentMB, budgetMB));
+                ImGui::Text("Target: %.1f MB", textureResidency.GetTargetBytes()/megabyte);
+                ImGui::Text("Pending loads: %i", textureResidency.GetPendingLoads());
+
+                if (ImGui::BeginTable("Textures", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                {
+                    ImGui::TableSetupColumn("Texture");
+                    ImGui::TableSetupColumn("Resident");
+                    ImGui::TableSetupColumn("Required");
+                    ImGui::TableSetupColumn("Size (MB)");
+                    ImGui::TableSetupColumn("Idle");
+                    ImGui::TableHeadersRow();
+
+                    for (TextureHandle handle = 0; handle < textureResidency.GetTextureCount(); handle++)
+                    {
+                        TextureResidencyStats stats = textureResidency.GetStats(handle);
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(GetFileName(stats.path));
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%ix%i", stats.baseWidth >> stats.residentMip, stats.baseHeight >> stats.residentMip);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%ix%i", stats.baseWidth >> stats.requiredMip, stats.baseHeight >> stats.requiredMip);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2f", stats.residentBytes/megabyte);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", stats.framesSinceUse);
+                    }
+                    ImGui::EndTable();
+                }
+
+                ImGui::Separator();
+                ImGui::Text("Virtual Textures");
+                const char* virtualTextureNames[] = { "Earth surface", "Moon surface" };
+                for (int i = 0; i < 2; i++)
+                {
+                    ImGui::Text("%s: %i / %i tiles, %i pending", virtualTextureNames[i],
+                                virtualTextures[i]->GetResidentPages(),
+                                virtualTextures[i]->GetCacheCapacity(),
+                                virtualTextures[i]->GetPendingPages());
+                }
+            }
+            ImGui::End();
             
+            // Picking and spatial queries on the body hierarchy
+            if (ImGui::Begin("Scene Queries"))
+            {
+                ImGui::Text("Bodies: %i, tree height %i, %i reinserted", bodyTree.GetProxyCount(), bodyTree.GetHeight(), bodyTree.GetReinsertCount());
+                ImGui::Separator();
+
+                Vector3 queryCenter = Vector3Zero();
+                const char* queryCenterName = "origin";
+                if (selectedBody >= 0)
+                {
+                    CelestialBody* body = bodies[selectedBody];
+                    queryCenter = body->GetPosition();
+                    queryCenterName = body->GetName().c_str();
+                    ImGui::Text("Selected: %s", queryCenterName);
+                    ImGui::Text("Position: %.2f, %.2f, %.2f", queryCenter.x, queryCenter.y, queryCenter.z);
+                    ImGui::Text("Distance: %.2f", Vector3Distance(camera.position, queryCenter));
+                    if (ImGui::Button("Focus Camera"))
+                    {
+                        camera.target = queryCenter;
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Clear Selection"))
+                    {
+                        selectedBody = -1;
+                    }
+                }
+                else
+                {
+                    ImGui::Text("Click a body in the Camera View to select it");
+                }
+
+                ImGui::Separator();
+                ImGui::SliderFloat("Query Radius", &queryRadius, 0.1f, 20.0f);
+                queryResults.clear();
+                bodyTree.QuerySphere(queryCenter, queryRadius, queryResults);
+                ImGui::Text("Within %.1f of %s: %i", queryRadius, queryCenterName, (int)queryResults.size());
+                for (int result : queryResults)
+                {
+                    ImGui::BulletText("%s", bodies[result]->GetName().c_str());
+                }
+
+                ImGui::Separator();
+                ImGui::SliderFloat("Close Approach", &closeApproachDistance, 0.1f, 10.0f);
+                closeApproaches.clear();
+                bodyTree.QueryClosePairs(closeApproachDistance, closeApproaches);
+                for (const std::pair<int, int>& pair : closeApproaches)
+                {
+                    CelestialBody* first = bodies[pair.first];
+                    CelestialBody* second = bodies[pair.second];
+                    float gap = Vector3Distance(first->GetPosition(), second->GetPosition()) - first->GetRadius() - second->GetRadius();
+                    ImGui::BulletText("%s - %s: %.2f", first->GetName().c_str(), second->GetName().c_str(), gap);
+                }
+            }
+            ImGui::End();
+
+            // Job system statistics and scaling test
+            if (ImGui::Begin("Job System"))
+            {
+                ImGui::Text("Threads: %i", jobSystem.GetThreadCount());
+                ImGui::Text("Frame graph: %i tasks", frameGraph.GetTaskCount());
+                ImGui::Text("Jobs: %i (%i stolen)", jobSystem.GetExecutedJobs(), jobSystem.GetStolenJobs());
+                ImGui::Text("Visible bodies: %i / %i", drawCount, bodyCount);
+
+                ImGui::Separator();
+                ImGui::SliderInt("Test Bodies", &scalingTestItems, 1000, 200000);
+                if (ImGui::Button("Run Scaling Test"))
+                {
+                    // Same work as PrepareDraw for synthetic bodies (JobScaling runs it headless)
+                    std::vector<Matrix> testModels(scalingTestItems);
+                    std::vector<unsigned char> testVisible(scalingTestItems);
+                    scalingResults = MeasureJobScaling(hardwareThreads, scalingTestItems, 256, [&](int first, int last) {
+                        for (int i = first; i < last; i++) {
+                            testVisible[i] = PrepareTestBody(i, viewProjection, testModels[i]);
+                        }
+                    });
+
+                    // The test allocates on purpose, do not count it against the frame loop
+                    frameAllocations.ResetSteadyState();
+                }
+
+                if (!scalingResults.empty() && ImGui::BeginTable("Scaling", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                {
+                    ImGui::TableSetupColumn("Threads");
+                    ImGui::TableSetupColumn("Time (ms)");
+                    ImGui::TableSetupColumn("Speedup");
+                    ImGui::TableHeadersRow();
+
+                    for (const JobScalingResult& result : scalingResults)
+                    {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%i", result.threadCount);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", result.milliseconds);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2fx", result.speedup);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+            ImGui::End();
+
+            // Frame arena and heap activity of the last finished frame
+            if (ImGui::Begin("Profiler"))
+            {
+                const float kilobyte = 1024.0f;
+                ImGui::Text("Frame: %.2f ms (%i FPS)", GetFrameTime()*1000.0f, GetFPS());
+
+                ImGui::Separator();
+                ImGui::Text("Frame Arena");
+                float arenaKB = frameArena.GetLastFrameBytes()/kilobyte;
+                float capacityKB = frameArena.GetCapacity()/kilobyte;
+                ImGui::ProgressBar(arenaKB/capacityKB, ImVec2(-1, 0), TextFormat("%.1f / %.0f KB", arenaKB, capacityKB));
+                ImGui::Text("Peak: %.1f KB, overflow: %.1f KB", frameArena.GetPeakBytes()/kilobyte, frameArena.GetLastOverflowBytes()/kilobyte);
+
+                ImGui::Separator();
+                ImGui::Text("Heap (%s)", IsAllocationHookEnabled() ? "operator new and ImGui" : "ImGui only, build with TRACK_ALLOCATIONS");
+                ImGui::SetItemTooltip("raylib's own allocations are not counted, in the loop only texture streaming makes them");
+                const AllocationStats& frameHeap = frameAllocations.GetLastFrame();
+                ImGui::Text("Allocations: %llu (%llu bytes)", (unsigned long long)frameHeap.allocations, (unsigned long long)frameHeap.bytes);
+                ImGui::Text("Frees: %llu", (unsigned long long)frameHeap.frees);
+                if (frameAllocations.IsSteadyState())
+                {
+                    ImGui::Text("Steady-state frames that allocated: %i", frameAllocations.GetViolationCount());
+                    if (frameAllocations.GetViolationCount() > 0)
+                    {
+                        ImGui::Text("Last at frame %llu of %llu", (unsigned long long)frameAllocations.GetLastViolationFrame(),
+                                    (unsigned long long)frameAllocations.GetFrameIndex());
+                    }
+                }
+                else
+                {
+                    ImGui::Text("Warming up");
+                }
+                if (ImGui::Button("Restart Warm-up"))
+                {
+                    frameAllocations.ResetSteadyState();
+                }
+            }
+            ImGui::End();
+
             // End ImGui frame
             rlImGuiEnd();
             
             DrawFPS(5, 5);
             
         EndDrawing();
+
+        // Everything allocated from the arena this frame is released here
+        frameArena.Reset();
+        frameAllocations.EndFrame();
     }
     
     // Shutdown ImGui before closing
@@ -247,6 +798,15 @@ int main()
     
     earth = CelestialBody(); // Clean up Earth celestial body
     moon = CelestialBody();   // Clean up Moon celestial body
+    textureResidency.Unload(); // Release streamed textures while the GL context is alive
+    earthSurface.Unload();
+    moonSurface.Unload();
+    virtualTextureFeedback.Unload();
+    orbitTrails.Unload();
+    atmosphere.Unload();
+    clusteredLights.Unload();
+    jobSystem.Stop();
+    telemetry.Close();
     // No need to manually unload textures and models, the CelestialBody destructor will handle it
     CloseWindow();     // Close window and OpenGL context
     